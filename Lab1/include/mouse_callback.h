@@ -1,8 +1,28 @@
 #ifndef LAB0_MOUSE_CALLBACK_H
 #define LAB0_MOUSE_CALLBACK_H
 
-void mouseCallback(int event, int x, int y, int flags, void *data);
+#include <opencv2/core.hpp>
+#include "vision_core/color_segmenter.h"
+#include "vision_core/region_stats.h"
+#include "vision_core/tiled_viewer.h"
 
-#endif //LAB0_MOUSE_CALLBACK_H
+// pixels within THRESHOLD of the reference colour on each channel are recoloured
+#define THRESHOLD 80
 
+/**
+ * What the callback needs, built once per loaded image.
+ */
+struct ClickContext {
+    cv::Mat image;
+    // integral images of image, answering the statistics of each click without going through the pixels
+    RegionStats stats;
+    ColorSegmenter segmenter;
+    TiledViewer *viewer = nullptr;
+};
 
+/**
+ * @param data the ClickContext of the window, x and y in image coordinates (TiledViewer callback)
+ */
+void mouseCallback(int event, int x, int y, int flags, void *data);
+
+#endif //LAB0_MOUSE_CALLBACK_H
@@ -15,11 +15,17 @@ int main() {
         printf("../data/robocup.jpg NOT FOUND!");
         return 1;
     }
-    resize(image, image, Size(image.cols/2, image.rows/2));
-    namedWindow(winName, WINDOW_AUTOSIZE);
-    imshow(winName, image);
-    setMouseCallback(winName, mouseCallback, (void*) &image);
+    // full resolution, the viewer fits it in the screen and maps the clicks back to image coordinates
+    TiledViewer viewer(winName);
+    viewer.show(image);
 
-    waitKey(0);
+    ClickContext context;
+    context.image = image;
+    context.stats.build(image);
+    context.segmenter.setReference(Vec3b(35, 155, 205), Vec3i::all(THRESHOLD));
+    context.viewer = &viewer;
+    viewer.setMouseCallback(mouseCallback, (void*) &context);
+
+    viewer.waitKey(0);
     return 0;
 }
@@ -1,9 +1,9 @@
 #include <opencv2/opencv.hpp>
+#include "mouse_callback.h"
+#include "vision_core/trace.h"
 
 #define RECT_Y_LEN 9
 #define RECT_X_LEN 9
-#define THRESHOLD 80
-#define AREA_LEN 20
 
 using namespace cv;
 using namespace std;
@@ -12,32 +12,22 @@ void mouseCallback(int event, int x, int y, int flags, void *data) {
     if (event != EVENT_LBUTTONDOWN)
         return;
 
-    //cout << "x: " << x << "   y: " << y << endl;
-
-    //Mat image_copy = (*(Mat*) data).clone();
-    Mat image_copy = *(Mat*) data;
+    TRACE_SCOPE("lab1.mouse_callback");
 
-    Rect rect(x, y, RECT_X_LEN, RECT_Y_LEN);
-    Scalar avg = mean(image_copy(rect));
-    cout << "Mean: " << avg << endl;
+    //cout << "x: " << x << "   y: " << y << endl;
 
-    for (int row = x-AREA_LEN; row <= x+AREA_LEN; row++) {
-        for (int col = y-AREA_LEN; col <= y+AREA_LEN; col++) {
+    ClickContext &context = *(ClickContext*) data;
+    Mat &image = context.image;
 
-            if (
-                    abs(image_copy.at<Vec3b>(col, row)[0] - 35) < THRESHOLD
-                    && abs(image_copy.at<Vec3b>(col, row)[1] - 155) < THRESHOLD
-                    && abs(image_copy.at<Vec3b>(col, row)[2] - 205) < THRESHOLD
-                    ) {
+    Scalar avg, variance;
+    context.stats.query(Rect(x, y, RECT_X_LEN, RECT_Y_LEN), avg, variance);
+    cout << "Mean: " << avg << "   Variance: " << variance << endl;
 
-                cout << "Setting pixels" << endl;
-                image_copy.at<Vec3b>(col, row)[0] = 92;
-                image_copy.at<Vec3b>(col, row)[1] = 37;
-                image_copy.at<Vec3b>(col, row)[2] = 201;
-            }
-        }
+    // the whole image in one pass, instead of the 41x41 window around the click.
+    // Pixels changed only by the first click: the statistics follow the displayed image
+    if (context.segmenter.recolor(image, Scalar(92, 37, 201)) > 0) {
+        context.stats.build(image);
+        context.viewer->show(image);
     }
 
-    imshow("Image", image_copy);
-
-}
\ No newline at end of file
+}
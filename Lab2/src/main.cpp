@@ -1,12 +1,20 @@
+#include <climits>
+#include <cstdlib>
 #include <iostream>
+#include <memory>
 #include <opencv2/opencv.hpp>
 #include <opencv2/calib3d.hpp>
 #include <opencv2/highgui.hpp>
 #include <opencv2/imgproc.hpp>
 
-#include <filesystem>
+#include <opencv2/core/utils/filesystem.hpp>
+
+#include "vision_core/async_video_io.h"
+#include "vision_core/calibration_coverage.h"
+#include "vision_core/image_io.h"
+#include "vision_core/tiled_viewer.h"
+#include "vision_core/trace.h"
 
-namespace fs = std::filesystem;
 using namespace cv;
 using namespace std;
 
@@ -18,20 +26,114 @@ const int CB_ROWS = 5;
 const int CB_COLS = 6;
 const float EDGE_LEN = 0.11;
 
+// Views kept from a calibration video by default
+const int FRAME_BUDGET = 40;
+// Width the frames of a video are searched for the board at
+const int DETECT_WIDTH = 640;
+
+/**
+ * Keeps the views of the board in a video which add coverage (see CalibrationFrameSelector), up to budget views:
+ * the board is searched in every frame at low resolution, only the corners of the kept views are refined at full
+ * resolution. Stops at the end of the video, when the budget is reached or on ESC in the preview.
+ * @return false if the video can't be opened
+ */
+static bool selectVideoViews(const string &path, int budget, Size cb_size, vector<Mat> &images, vector<string> &names,
+                             vector<vector<Point2f>> &points2d) {
+    AsyncVideoReader reader(path);
+    if (!reader.isOpened())
+        return false;
+
+    CalibrationCoverageOptions options;
+    options.budget = budget;
+    unique_ptr<CalibrationFrameSelector> selector;
+
+    Mat gray, small, preview;
+    vector<Point2f> corners;
+    int frames = 0;
+    Mat *frame;
+    while ((frame = reader.next()) != nullptr) {
+        int index = frames++;
+        if (!selector)
+            selector.reset(new CalibrationFrameSelector(frame->size(), cb_size, options));
+
+        cvtColor(*frame, gray, COLOR_BGR2GRAY);
+        double scale = min(1.0, (double) DETECT_WIDTH / gray.cols);
+        resize(gray, small, Size(), scale, scale, INTER_AREA);
+
+        bool found;
+        {
+            TRACE_SCOPE("lab2.video_find_chessboard");
+            // the fast check rejects the frames without a board quickly
+            found = findChessboardCorners(small, cb_size, corners,
+                                          CALIB_CB_ADAPTIVE_THRESH | CALIB_CB_NORMALIZE_IMAGE | CALIB_CB_FAST_CHECK);
+        }
+        for (auto &c : corners)
+            c /= scale;
+
+        bool keep = found && selector->wouldAccept(corners);
+        TRACE_COUNT(keep ? "lab2.views_kept" : "lab2.views_skipped", 1);
+        if (keep) {
+            TermCriteria criteria(TermCriteria::EPS | TermCriteria::MAX_ITER, 30, 0.001);
+            TRACE_SCOPE("lab2.corner_subpix");
+            cornerSubPix(gray, corners, Size(11, 11), Size(-1, -1), criteria);
+
+            selector->add(corners);
+            images.push_back(frame->clone());
+            names.push_back(path + " frame " + to_string(index));
+            points2d.push_back(corners);
+        }
+
+        // preview at the detection resolution, with the image cells already covered shaded
+        resize(*frame, preview, small.size(), 0, 0, INTER_AREA);
+        selector->draw(preview);
+        if (found) {
+            for (auto &c : corners)
+                c *= scale;
+            drawChessboardCorners(preview, cb_size, corners, found);
+        }
+        imshow("Calibration video", preview);
+        int key = waitKey(1);
+
+        reader.recycle(frame);
+        if (selector->full() || key == 27)
+            break;
+    }
+    destroyWindow("Calibration video");
+
+    if (selector)
+        cout << "Kept " << selector->accepted() << " views out of " << frames << " frames, "
+             << cvRound(100 * selector->spatialCoverage()) << "% of the image covered, "
+             << selector->posesCovered() << " of " << CalibrationFrameSelector::poseBins() << " poses" << endl;
+    return true;
+}
+
 int main(int argc, char* argv[]) {
-    if (argc != 3) {
-        cout << "USAGE: " << argv[0] << " CB_FOLDER_PATH TEST_IMG_PATH" << endl;
-        cout << "CB_FOLDER_PATH: Path to the folder containing calibration images" << endl;
+    if (argc != 3 && argc != 4) {
+        cout << "USAGE: " << argv[0] << " CB_FOLDER_PATH TEST_IMG_PATH [FRAME_BUDGET]" << endl;
+        cout << "CB_FOLDER_PATH: Path to the folder containing calibration images, or to a video of the checkerboard" << endl;
         cout << "TEST_IMG_PATH: Path to the image that will be corrected according with the computed parameters" << endl;
+        cout << "FRAME_BUDGET: views of a video kept at most, only those adding coverage of the image or of the poses of" << endl;
+        cout << "              the board are (default " << FRAME_BUDGET << ")" << endl;
 
         return 1;
     }
 
     char* CB_DIR = argv[1];
     char* TEST_IMAGE_PATH = argv[2];
+    int frameBudget = FRAME_BUDGET;
+    if (argc > 3) {
+        // strtol rather than atoi, which takes "abc" for 0 and "10x" for 10
+        char *end;
+        long budget = strtol(argv[3], &end, 10);
+        if (end == argv[3] || *end != '\0' || budget <= 0 || budget > INT_MAX) {
+            cout << "FRAME_BUDGET must be a positive integer, got " << argv[3] << endl;
+            return 1;
+        }
+        frameBudget = (int) budget;
+    }
 
     vector<Mat> images;
-    vector<filesystem::path> names;
+    vector<string> names;
     vector<vector<Point3f> > points3d;
     vector<vector<Point2f>> points2d;
     vector<double> imagesError;
@@ -45,32 +147,52 @@ int main(int argc, char* argv[]) {
         }
     }
 
-    // Load checkerboard images
-    for (const auto & entry : fs::directory_iterator(CB_DIR)) {
-        images.push_back(imread(entry.path()));
-        names.push_back(entry.path());
-    }
+    if (!utils::fs::isDirectory(CB_DIR)) {
+        // Video: only the views adding coverage, all with the board found
+        if (!selectVideoViews(CB_DIR, frameBudget, cb_size, images, names, points2d)) {
+            cout << "Can't open " << CB_DIR << endl;
+            return 1;
+        }
+        points3d.assign(points2d.size(), worldCoords);
+    } else {
+        // Checkerboard images are decoded in the background while the corners of the ones already loaded are detected
+        ImageFolderLoader loader(CB_DIR);
 
-    // Detect checkerboard intersections per image using cv::findChessboardCorners
-    vector<Point2f> currImgCorners;
-    Mat gray;
+        // Detect checkerboard intersections per image using cv::findChessboardCorners
+        vector<Point2f> currImgCorners;
+        Mat gray;
 
-    for (int i=0; i<images.size(); i++) {
+        for (const auto &loaded : loader) {
+            int i = images.size();
+            images.push_back(loaded.image);
+            names.push_back(loaded.path);
 
-        cvtColor(images[i], gray, COLOR_BGR2GRAY);
-        bool found = findChessboardCorners(gray, cb_size, currImgCorners);
-        cout << "Elaborated image " << i << " of " << images.size() << endl;
+            cvtColor(images[i], gray, COLOR_BGR2GRAY);
+            bool found;
+            {
+                TRACE_SCOPE("lab2.find_chessboard_corners");
+                found = findChessboardCorners(gray, cb_size, currImgCorners);
+            }
+            TRACE_COUNT(found ? "lab2.boards_found" : "lab2.boards_missed", 1);
+            cout << "Elaborated image " << i << " of " << loader.size() << endl;
 
-        if (found) {
-            // refining pixel coordinates for given 2d points
-            TermCriteria criteria(TermCriteria::EPS | TermCriteria::MAX_ITER , 30, 0.001);
-            cornerSubPix(gray, currImgCorners, cb_size, cv::Size(-1,-1), criteria);
+            if (found) {
+                // refining pixel coordinates for given 2d points
+                TermCriteria criteria(TermCriteria::EPS | TermCriteria::MAX_ITER , 30, 0.001);
+                TRACE_SCOPE("lab2.corner_subpix");
+                cornerSubPix(gray, currImgCorners, cb_size, cv::Size(-1,-1), criteria);
             
-            points3d.push_back(worldCoords);
-            points2d.push_back(currImgCorners);
+                points3d.push_back(worldCoords);
+                points2d.push_back(currImgCorners);
 
-        } else
-            cout << "Corners not found for img: " << names[i] << endl;
+            } else
+                cout << "Corners not found for img: " << names[i] << endl;
+        }
+    }
+
+    if (points2d.empty()) {
+        cout << "Checkerboard not found in " << CB_DIR << endl;
+        return 1;
     }
 
     // Calibrate camera with cv::calibrateCamera()
@@ -79,7 +201,10 @@ int main(int argc, char* argv[]) {
     Mat cameraMatrix, distCoeffs;
     vector<Mat> rotations;
     vector<Mat> translations;
-    calibrateCamera(points3d, points2d, images[0].size(), cameraMatrix, distCoeffs, rotations, translations);
+    {
+        TRACE_SCOPE("lab2.calibrate_camera");
+        calibrateCamera(points3d, points2d, images[0].size(), cameraMatrix, distCoeffs, rotations, translations);
+    }
 
     // Print estimated intrinsic and distortion parameters
 
@@ -128,12 +253,13 @@ int main(int argc, char* argv[]) {
     // Show best-worst calib images
     string bestImgWin = "Best calib img - err: " + to_string(imagesError[bestIndex]) + " - name: " + string(names[bestIndex]);
     string worstImgWin = "Worst calib img - err: " + to_string(imagesError[worstIndex]) + " - name: " + string(names[worstIndex]);
-    namedWindow(bestImgWin, WINDOW_NORMAL);
-    namedWindow(worstImgWin, WINDOW_NORMAL);
-    imshow(bestImgWin, images[bestIndex]);
-    imshow(worstImgWin, images[worstIndex]);
+    {
+        TiledViewer bestViewer(bestImgWin), worstViewer(worstImgWin);
+        bestViewer.show(images[bestIndex]);
+        worstViewer.show(images[worstIndex]);
 
-    waitKey(0);
+        bestViewer.waitKey(0);
+    }
     destroyAllWindows();
 
     // Undistort and rectify the test image acquired with the same camera, check: cv::initUndistortRectifyMap()
@@ -144,15 +270,14 @@ int main(int argc, char* argv[]) {
     remap(test_image, result, map1x, map1y, cv::INTER_CUBIC);
     undistort(test_image, result, cameraMatrix, distCoeffs);
 
-    // Show result
-    resize(test_image, test_image, Size(768,576));
-    resize(result, result, Size(768, 576));
-
+    // Show result, side by side at full resolution
     hconcat(test_image, result, result);
-    namedWindow("Correction result");
-    imshow("Correction result", result);
+    {
+        TiledViewer viewer("Correction result");
+        viewer.show(result);
 
-    waitKey(0);
+        viewer.waitKey(0);
+    }
     destroyAllWindows();
 
     return 0;
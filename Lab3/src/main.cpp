@@ -1,7 +1,12 @@
 #include <iostream>
+#include <memory>
 #include <opencv2/opencv.hpp>
 #include <opencv2/highgui.hpp>
 #include <opencv2/imgproc.hpp>
+#include "vision_core/equalization.h"
+#include "vision_core/filters.h"
+#include "vision_core/tiled_viewer.h"
+#include "vision_core/trace.h"
 
 using namespace cv;
 using namespace std;
@@ -62,8 +67,8 @@ int main(int argc, char* argv[]) {
 void partOne() {
     Mat img = imread(IMG_PATH, IMREAD_COLOR);
 
-    namedWindow("Before - RGB", WINDOW_NORMAL);
-    imshow("Before - RGB", img);
+    TiledViewer before("Before - RGB");
+    before.show(img);
 
     // Print BGR histograms
     Mat channels[3];
@@ -79,50 +84,43 @@ void partOne() {
 
     showHistogram(histograms);
 
-    waitKey(0);
+    before.waitKey(0);
     destroyAllWindows();
 
     // Equalize histograms (BGR) and show results
     for (int i=0; i<3; i++) {
-        equalizeHist(channels[i], channels[i]);
+        {
+            TRACE_SCOPE("lab3.equalize_bgr_channel");
+            equalizeHist(channels[i], channels[i]);
+        }
         calcHist( &channels[i], 1, nullptr, Mat(), histograms[i], 1, &histSize, &histRange, true, false );
     }
     showHistogram(histograms);
 
     // Show equalized image
-    namedWindow("Equalized RGB", WINDOW_NORMAL);
+    TiledViewer equalizedViewer("Equalized RGB");
     merge(vector<Mat>({ channels[0], channels[1], channels[2] }), img);
-    imshow("Equalized RGB", img);
+    equalizedViewer.show(img);
 
-    waitKey(0);
+    equalizedViewer.waitKey(0);
     destroyAllWindows();
 
     // Repeat with HSV color space for each channel
-    Mat hsv = imread(IMG_PATH);
-    namedWindow("Before - HSV", WINDOW_NORMAL);
-    imshow("Before - HSV", hsv);
+    Mat original = imread(IMG_PATH);
+    TiledViewer beforeHSV("Before - HSV");
+    beforeHSV.show(original);
 
-    vector<Mat> channelsHSV(3);
-    cvtColor(hsv, hsv, COLOR_BGR2HSV);
-    split(hsv, channelsHSV);
-
-    // Equalize one channel and merge for each channel
+    // Equalize one channel at a time (H, S, V), each window keeps its own copy
+    vector<unique_ptr<TiledViewer>> channelViewers;
     for (int i=0; i<3; i++) {
-        Mat tmpCopy = channelsHSV[i].clone();
-        equalizeHist(channelsHSV[i], channelsHSV[i]);
-        merge(channelsHSV, hsv);
-
-        cvtColor(hsv, hsv, COLOR_HSV2BGR);
+        Mat equalized;
+        equalizeHSV(original, equalized, 1 << i);
 
-        string winName = "Equalized channel " + to_string(i);
-        namedWindow(winName, WINDOW_NORMAL);
-        imshow(winName, hsv);
-
-        // restore previous
-        channelsHSV[i] = tmpCopy;
+        channelViewers.emplace_back(new TiledViewer("Equalized channel " + to_string(i)));
+        channelViewers.back()->show(equalized);
     }
 
-    waitKey(0);
+    beforeHSV.waitKey(0);
     destroyAllWindows();
 }
 
@@ -177,25 +175,24 @@ void partTwo() {
 void updateMFWindow(int _, void* data) {
     MedianFilterData MFdata = *((MedianFilterData*) data);
     if (MFdata.kernelSize%2 != 1) return; // ignore odd kernel size
-    Mat result;
-    medianBlur(MFdata.src, result, MFdata.kernelSize);
-    imshow(MFdata.targetWin, result);
+    MedianFilter filter(MFdata.src, MFdata.kernelSize);
+    filter.doFilter();
+    imshow(MFdata.targetWin, filter.getResult());
 }
 
 void updateGFWindow(int _, void* data) {
     GaussianFilterData GFdata = *((GaussianFilterData*) data);
     if (GFdata.kernelSize%2 != 1) return; // ignore odd kernel size
-    Mat result;
-    GaussianBlur(GFdata.src, result, Size(GFdata.kernelSize, GFdata.kernelSize), GFdata.sigma, GFdata.sigma);
-    imshow(GFdata.targetWin, result);
+    GaussianFilter filter(GFdata.src, GFdata.kernelSize, GFdata.sigma);
+    filter.doFilter();
+    imshow(GFdata.targetWin, filter.getResult());
 }
 
 void updateBFWindow(int _, void* data) {
     BilateralFilterData BFdata = *((BilateralFilterData*) data);
-    Mat result;
-    int kernelSize = 6 * BFdata.sigmaSpace;
-    bilateralFilter(BFdata.src, result, kernelSize, BFdata.sigmaRange, BFdata.sigmaSpace);
-    imshow(BFdata.targetWin, result);
+    BilateralFilter filter(BFdata.src, BFdata.sigmaRange, BFdata.sigmaSpace);
+    filter.doFilter();
+    imshow(BFdata.targetWin, filter.getResult());
 }
 
 // hists = vector of 3 cv::mat of size nbins=256 with the 3 histograms
@@ -2,6 +2,8 @@
 #include <opencv2/opencv.hpp>
 #include <opencv2/highgui.hpp>
 #include <opencv2/imgproc.hpp>
+#include "vision_core/edge_detector.h"
+#include "vision_core/trace.h"
 
 using namespace std;
 using namespace cv;
@@ -19,6 +21,7 @@ void updateHoughWindow(int _, void* data);
 struct CannyData {
     int minThreshold = 283;
     int ratio = 3;
+    EdgeDetector detector;
     Mat src;
     Mat res;
     string targetWin;
@@ -41,14 +44,9 @@ const char* IMG_PATH = "../data/input.png";
 int main() {
     Mat src = imread(IMG_PATH, IMREAD_COLOR);
 
-    Mat srcGray;
-    Mat dst = Mat(src.size(), src.type());
-
-    cvtColor(src, srcGray, COLOR_BGR2GRAY);
-
     CannyData cannyData;
     cannyData.targetWin = "Tune canny params";
-    cannyData.src = srcGray;
+    cannyData.src = src;
     namedWindow(cannyData.targetWin, WINDOW_AUTOSIZE);
     createTrackbar("Minimum threshold: ", cannyData.targetWin, &cannyData.minThreshold, 401, updateCannyWindow,(void*)&cannyData);
     createTrackbar("Ratio: ", cannyData.targetWin, &cannyData.ratio, 50, updateCannyWindow,(void*)&cannyData);
@@ -59,7 +57,7 @@ int main() {
 
     HoughLinesData houghLinesData;
     houghLinesData.src = src;
-    Canny(cannyData.src, houghLinesData.edgeImg, cannyData.minThreshold, cannyData.ratio*cannyData.minThreshold);
+    cannyData.detector.detect(cannyData.src, houghLinesData.edgeImg, cannyData.minThreshold, cannyData.ratio*cannyData.minThreshold);
     houghLinesData.targetWin = "Tune Hough params";
 
     namedWindow(houghLinesData.targetWin, WINDOW_AUTOSIZE);
@@ -78,21 +76,24 @@ int main() {
 
 /**
  * Applies Canny Edge detector to data.src
- * showing the result.
+ * showing the result. The detector and the result buffer are reused across trackbar updates.
  * @param _ unused
  * @param data must be CannyData
  */
 void updateCannyWindow(int _, void* data) {
-    CannyData cannyData = *((CannyData*) data);
+    CannyData &cannyData = *((CannyData*) data);
     if (!cannyData.ratio)
         return;
 
-    if (cannyData.minThreshold) {
-        Canny(cannyData.src, cannyData.res, cannyData.minThreshold, cannyData.ratio*cannyData.minThreshold);
-        imshow(cannyData.targetWin, cannyData.res);
-    } else {
-        imshow(cannyData.targetWin, cannyData.src);
+    {
+        TRACE_SCOPE("lab4.canny");
+        cannyData.detector.detect(cannyData.src, cannyData.res, cannyData.minThreshold, cannyData.ratio*cannyData.minThreshold);
     }
+
+    if (cannyData.minThreshold)
+        imshow(cannyData.targetWin, cannyData.res);
+    else
+        imshow(cannyData.targetWin, cannyData.detector.gray());
 }
 
 /**
@@ -101,18 +102,21 @@ void updateCannyWindow(int _, void* data) {
  * @param data must be of type HoughLinesData
  */
 void updateHoughWindow(int _, void* data) {
-    HoughLinesData houghData = *((HoughLinesData *) data);
+    HoughLinesData &houghData = *((HoughLinesData *) data);
     Mat imgWithLines = houghData.src.clone();
 
     if (houghData.rhoAccumulator < 1 || houghData.thetaAccumulator < 1 || houghData.threshold < 1) return;
 
-    HoughLines(
-            houghData.edgeImg,
-            houghData.lines,
-            houghData.rhoAccumulator,
-            houghData.thetaAccumulator * CV_PI / 180,
-            houghData.threshold
-    );
+    {
+        TRACE_SCOPE("lab4.hough_lines");
+        HoughLines(
+                houghData.edgeImg,
+                houghData.lines,
+                houghData.rhoAccumulator,
+                houghData.thetaAccumulator * CV_PI / 180,
+                houghData.threshold
+        );
+    }
 
     // show the two strongest lines found
     for (int i = 0; i < 2 && i < houghData.lines.size(); i++) {
@@ -130,7 +134,10 @@ void updateHoughWindow(int _, void* data) {
     // find circles
     vector<Vec3f> circles;
 
-    HoughCircles(houghData.edgeImg, circles, HOUGH_GRADIENT, 1, houghData.edgeImg.rows/4, 100, houghData.circleAccThreshold, 0, houghData.circleMaxRadius);
+    {
+        TRACE_SCOPE("lab4.hough_circles");
+        HoughCircles(houghData.edgeImg, circles, HOUGH_GRADIENT, 1, houghData.edgeImg.rows/4, 100, houghData.circleAccThreshold, 0, houghData.circleMaxRadius);
+    }
 
     for(size_t i = 0; i < circles.size(); i++ ) {
         Point center(cvRound(circles[i][0]), cvRound(circles[i][1]));
@@ -0,0 +1,143 @@
+#include <cmath>
+#include <thread>
+#include <opencv2/imgproc.hpp>
+#include "stream_detector.h"
+#include "vision_core/trace.h"
+
+using namespace cv;
+using namespace std;
+
+StreamDetector::StreamDetector(StreamDetectorParams params, int pipeline_depth)
+    : params(params), slots(max(pipeline_depth, 3)) {
+}
+
+int StreamDetector::run(VideoCapture &cap, const ResultCallback &on_result) {
+    BlockingQueue<Slot*> free_slots, decoded, edged;
+    for (auto &slot : slots)
+        free_slots.push(&slot);
+
+    prevLines.clear();
+
+    thread decoder(&StreamDetector::decodeStage, this, ref(cap), ref(free_slots), ref(decoded));
+    thread edge_detector(&StreamDetector::edgeStage, this, ref(decoded), ref(edged));
+
+    int processed = 0;
+    FrameResult result;
+    Slot *slot;
+    while (edged.pop(slot)) {
+        voteStage(*slot, result);
+        on_result(slot->frame, result);
+        processed++;
+        free_slots.push(slot);
+    }
+
+    free_slots.close();
+    decoder.join();
+    edge_detector.join();
+
+    return processed;
+}
+
+void StreamDetector::decodeStage(VideoCapture &cap, BlockingQueue<Slot*> &free_slots, BlockingQueue<Slot*> &decoded) {
+    int index = 0;
+    Slot *slot;
+    while (free_slots.pop(slot)) {
+        slot->decodeTick = getTickCount();
+        // read() decodes into the existing buffer when the frame size doesn't change
+        bool decoded_frame;
+        {
+            TRACE_SCOPE("lab4.stream.decode");
+            decoded_frame = cap.read(slot->frame) && !slot->frame.empty();
+        }
+        if (!decoded_frame)
+            break;
+
+        slot->index = index++;
+        decoded.push(slot);
+    }
+    decoded.close();
+}
+
+void StreamDetector::edgeStage(BlockingQueue<Slot*> &decoded, BlockingQueue<Slot*> &edged) {
+    Slot *slot;
+    while (decoded.pop(slot)) {
+        TRACE_SCOPE("lab4.stream.canny");
+        edgeDetector.detect(slot->frame, slot->edges, params.minThreshold, params.ratio * params.minThreshold);
+        edged.push(slot);
+    }
+    edged.close();
+}
+
+void StreamDetector::voteStage(Slot &slot, FrameResult &result) {
+    result.index = slot.index;
+    result.lines.clear();
+
+    {
+        TRACE_SCOPE("lab4.stream.hough_lines_seeded");
+        result.seeded = findLinesAroundPrevious(slot.edges, result.lines);
+    }
+    TRACE_COUNT(result.seeded ? "lab4.stream.seeded_frames" : "lab4.stream.full_search_frames", 1);
+    if (!result.seeded) {
+        TRACE_SCOPE("lab4.stream.hough_lines");
+        result.lines.clear();
+        HoughLines(slot.edges, houghBuffer, params.rhoAccumulator, params.thetaAccumulator * CV_PI / 180, params.threshold);
+
+        // lines are sorted by votes, keep the strongest ones
+        for (int i = 0; i < params.maxLines && i < (int) houghBuffer.size(); i++)
+            result.lines.push_back(houghBuffer[i]);
+    }
+    prevLines = result.lines;
+
+    {
+        TRACE_SCOPE("lab4.stream.hough_circles");
+        HoughCircles(slot.edges, result.circles, HOUGH_GRADIENT, 1, slot.edges.rows/4, 100, params.circleAccThreshold, 0, params.circleMaxRadius);
+    }
+
+    result.latencyMs = (getTickCount() - slot.decodeTick) * 1000. / getTickFrequency();
+}
+
+/**
+ * Searches each line of the previous frame only inside a small theta window around it:
+ * the accumulator cost is proportional to the number of theta bins, so this is much cheaper
+ * than a full search as long as the lines move smoothly.
+ * @return false if a line could not be found, in which case a full search is needed
+ */
+bool StreamDetector::findLinesAroundPrevious(const Mat &edges, vector<Vec2f> &lines) {
+    if ((int) prevLines.size() < params.maxLines)
+        return false;
+
+    double theta_step = params.thetaAccumulator * CV_PI / 180;
+    double window = params.seedThetaWindow * CV_PI / 180;
+
+    for (const auto &prev : prevLines) {
+        double min_theta = prev[1] - window;
+        double max_theta = prev[1] + window;
+
+        // near vertical lines wrap around theta = 0 / pi with opposite rho, leave them to the full search
+        if (min_theta < 0 || max_theta > CV_PI)
+            return false;
+
+        HoughLines(edges, houghBuffer, params.rhoAccumulator, theta_step, params.threshold, 0, 0, min_theta, max_theta);
+
+        // take the strongest line which has not already been assigned to another previous line
+        bool found = false;
+        for (const auto &candidate : houghBuffer) {
+            bool duplicate = false;
+            for (const auto &taken : lines) {
+                if (abs(candidate[0] - taken[0]) <= 2 * params.rhoAccumulator && abs(candidate[1] - taken[1]) < theta_step)
+                    duplicate = true;
+            }
+
+            if (!duplicate) {
+                lines.push_back(candidate);
+                found = true;
+                break;
+            }
+        }
+
+        if (!found)
+            return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,67 @@
+#ifndef LAB4_STREAM_DETECTOR_H
+#define LAB4_STREAM_DETECTOR_H
+
+#include <functional>
+#include <vector>
+#include <opencv2/core.hpp>
+#include <opencv2/videoio.hpp>
+
+#include "vision_core/blocking_queue.h"
+#include "vision_core/edge_detector.h"
+#include "vision_core/stream_detector_params.h"
+
+struct FrameResult {
+    int index = 0;
+    std::vector<cv::Vec2f> lines;
+    std::vector<cv::Vec3f> circles;
+    // true if the lines have been found inside the theta windows of the previous frame
+    bool seeded = false;
+    // time from the start of the frame decode to the end of the voting stage
+    double latencyMs = 0;
+};
+
+/**
+ * Runs the Lab4 lane and sign detector on every frame of a video.
+ * Decode, edge detection and voting run on three threads connected by queues, so consecutive frames
+ * overlap. Frame and edge buffers live in a fixed ring of slots and are reused across frames,
+ * the edge detector keeps its gradient buffers between frames.
+ */
+class StreamDetector {
+public:
+    using ResultCallback = std::function<void(const cv::Mat &frame, const FrameResult &result)>;
+
+    /**
+     * @param params detector parameters
+     * @param pipeline_depth number of frame slots in flight, at least one per stage
+     */
+    explicit StreamDetector(StreamDetectorParams params = StreamDetectorParams(), int pipeline_depth = 4);
+
+    /**
+     * Processes the whole stream, calling on_result on the caller thread for each frame, in order.
+     * The frame passed to on_result is only valid during the call.
+     * @return number of processed frames
+     */
+    int run(cv::VideoCapture &cap, const ResultCallback &on_result);
+
+private:
+    struct Slot {
+        cv::Mat frame;
+        cv::Mat edges;
+        int index = 0;
+        cv::int64 decodeTick = 0;
+    };
+
+    StreamDetectorParams params;
+    std::vector<Slot> slots;
+    EdgeDetector edgeDetector;
+    std::vector<cv::Vec2f> prevLines;
+    std::vector<cv::Vec2f> houghBuffer;
+
+    void decodeStage(cv::VideoCapture &cap, BlockingQueue<Slot*> &free_slots, BlockingQueue<Slot*> &decoded);
+    void edgeStage(BlockingQueue<Slot*> &decoded, BlockingQueue<Slot*> &edged);
+    void voteStage(Slot &slot, FrameResult &result);
+
+    bool findLinesAroundPrevious(const cv::Mat &edges, std::vector<cv::Vec2f> &lines);
+};
+
+#endif //LAB4_STREAM_DETECTOR_H
@@ -0,0 +1,105 @@
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <opencv2/core.hpp>
+#include <opencv2/highgui.hpp>
+#include <opencv2/imgproc.hpp>
+#include "stream_detector.h"
+
+using namespace cv;
+using namespace std;
+
+/**
+ * Draws the detected lines and circles on frame, as done by the interactive Lab4 program.
+ */
+void drawResult(Mat &frame, const FrameResult &result) {
+    for (const auto &l : result.lines) {
+        float rho = l[0], theta = l[1];
+        double a = cos(theta), b = sin(theta);
+        double x0 = a * rho, y0 = b * rho;
+        Point pt1(cvRound(x0 + 1000 * (-b)), cvRound(y0 + 1000 * (a)));
+        Point pt2(cvRound(x0 - 1000 * (-b)), cvRound(y0 - 1000 * (a)));
+        line(frame, pt1, pt2, Scalar(0, 0, 255), 2);
+    }
+
+    for (const auto &c : result.circles) {
+        Point center(cvRound(c[0]), cvRound(c[1]));
+        circle(frame, center, 3, Scalar(0,255,0), -1, 8, 0);
+        circle(frame, center, cvRound(c[2]), Scalar(0,255,0), 3, 8, 0);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2 || argc > 4) {
+        cout << "USAGE: " << argv[0] << " VIDEO_PATH [LATENCY_CSV] [--show]" << endl;
+        cout << "VIDEO_PATH: video on which lane lines and signs are detected" << endl;
+        cout << "LATENCY_CSV: optional file where the per-frame latency is written" << endl;
+        cout << "--show: display the detections (slows down the pipeline)" << endl;
+
+        return 1;
+    }
+
+    string video_path(argv[1]);
+    string csv_path;
+    bool show = false;
+    for (int i = 2; i < argc; i++) {
+        if (string(argv[i]) == "--show")
+            show = true;
+        else
+            csv_path = argv[i];
+    }
+
+    VideoCapture cap(video_path);
+    if (!cap.isOpened()) {
+        cout << video_path << " NOT FOUND!" << endl;
+        return 1;
+    }
+
+    ofstream csv;
+    if (!csv_path.empty()) {
+        csv.open(csv_path);
+        csv << "frame,latency_ms,seeded,lines,circles" << endl;
+    }
+
+    vector<double> latencies;
+    int seeded_frames = 0;
+    StreamDetector detector;
+
+    int64 start = getTickCount();
+    int frames = detector.run(cap, [&](const Mat &frame, const FrameResult &result) {
+        latencies.push_back(result.latencyMs);
+        seeded_frames += result.seeded;
+
+        if (csv.is_open())
+            csv << result.index << "," << result.latencyMs << "," << result.seeded << ","
+                << result.lines.size() << "," << result.circles.size() << endl;
+
+        if (show) {
+            Mat img = frame.clone();
+            drawResult(img, result);
+            imshow("Stream detector", img);
+            waitKey(1);
+        }
+    });
+    double elapsed = (getTickCount() - start) / getTickFrequency();
+
+    if (frames == 0) {
+        cout << "No frames decoded from " << video_path << endl;
+        return 1;
+    }
+
+    sort(latencies.begin(), latencies.end());
+    double mean_latency = 0;
+    for (double l : latencies)
+        mean_latency += l;
+    mean_latency /= latencies.size();
+
+    cout << "Frames: " << frames << " (" << seeded_frames << " seeded from the previous frame)" << endl;
+    cout << "Throughput: " << frames / elapsed << " fps" << endl;
+    cout << "Latency ms - mean: " << mean_latency
+         << "  p50: " << latencies[latencies.size() / 2]
+         << "  p95: " << latencies[min(latencies.size() - 1, latencies.size() * 95 / 100)]
+         << "  max: " << latencies.back() << endl;
+
+    return 0;
+}
@@ -1,64 +1,22 @@
 #ifndef LAB5__PANORAMIC__UTILS__H
 #define LAB5__PANORAMIC__UTILS__H
 
-#include <memory>
-#include <iostream>
-
 #include <opencv2/core.hpp>
-#include <opencv2/highgui.hpp>
-#include <opencv2/xfeatures2d.hpp>
-#include <opencv2/imgproc.hpp>
-#include <opencv2/ccalib.hpp>
-#include <opencv2/stitching.hpp>
+#include "vision_core/projection.h"
 
 class PanoramicUtils
 {
 public:
+  /**
+   * Projection of image on a cylinder, angle is half the field of view of the camera in degrees.
+   * The per-pixel loop now lives in vision_core (CylindricalProjector), which caches the mapping.
+   */
   static
   cv::Mat cylindricalProj(
       const cv::Mat& image,
       const double angle)
   {
-    cv::Mat tmp,result;
-
-    // cv::cvtColor(image, tmp, cv::COLOR_BGR2GRAY);
-    tmp = image.clone();
-    result = tmp.clone();
-
-    double alpha(angle / 180 * CV_PI);
-    double d((image.cols / 2.0) / tan(alpha));
-    double r(d/cos(alpha));
-    double d_by_r(d / r);
-    int half_height_image(image.rows / 2);
-    int half_width_image(image.cols / 2);
-
-    for (int x = - half_width_image + 1,
-         x_end = half_width_image; x < x_end; ++x)
-    {
-      for(int y = - half_height_image + 1,
-          y_end = half_height_image; y < y_end; ++y)
-      {
-        double x1(d * tan(x / r));
-        double y1(y * d_by_r / cos(x / r));
-
-        if (x1 < half_width_image &&
-            x1 > - half_width_image + 1 &&
-            y1 < half_height_image &&
-            y1 > -half_height_image + 1)
-        {
-            /*
-          result.at<uchar>(y + half_height_image, x + half_width_image)
-              = tmp.at<uchar>(round(y1 + half_height_image),
-                              round(x1 + half_width_image));
-            */
-            result.at<cv::Vec3b>(y + half_height_image, x + half_width_image)
-                    = tmp.at<cv::Vec3b>(round(y1 + half_height_image),
-                                    round(x1 + half_width_image));
-        }
-      }
-    }
-
-    return result;
+    return ::cylindricalProj(image, angle);
   }
 };
 
@@ -1,35 +1,32 @@
+#include <cmath>
 #include <iostream>
 #include <opencv2/core.hpp>
 #include <opencv2/highgui.hpp>
-#include "panoramic_image.h"
+#include "vision_core/equalization.h"
+#include "vision_core/panoramic_image.h"
+#include "vision_core/tiled_canvas.h"
+#include "vision_core/tiled_viewer.h"
 
 using namespace std;
 using namespace cv;
-using namespace cv::xfeatures2d;
-
-Mat equalize(Mat input) {
-    vector<Mat> channelsHSV(3);
-    Mat hsv;
-    cvtColor(input, hsv, COLOR_BGR2HSV);
-    split(hsv, channelsHSV);
-
-    equalizeHist(channelsHSV[1], channelsHSV[1]);
-    equalizeHist(channelsHSV[2], channelsHSV[2]);
-    merge(channelsHSV, hsv);
-
-    cvtColor(hsv, hsv, COLOR_HSV2BGR);
-
-    return hsv;
-}
 
 int main(int argc, char* argv[]) {
 
-    if (argc != 4) {
+    if (argc < 4 || argc > 10) {
         // argv[0] is the executable name
-        cout << "USAGE: $" << argv[0] << " PANORAMIC_FOLDER_PATH CAMERA_FOV MATCH_FILTER_RATIO" << endl;
+        cout << "USAGE: $" << argv[0] << " PANORAMIC_FOLDER_PATH CAMERA_FOV MATCH_FILTER_RATIO [OVERLAP] [MAX_KEYPOINTS] [ALIGN_SCALE] [REFINE_WINDOW] [PHASE_RESPONSE] [OUTPUT]" << endl;
         cout << "PANORAMIC_FOLDER_PATH: path to the lab image" << endl;
         cout << "CAMERA_FOV: field of view of the camera used to take the pictures inside PANORAMIC_FOLDER_PATH" << endl;
         cout << "MATCH_FILTER_RATIO: used to discard pair of matches with distance > match_filter_ratio * min_pair_distance" << endl;
+        cout << "OVERLAP: fraction of the width shared by consecutive pictures (e.g. 0.3), or auto to estimate it on" << endl;
+        cout << "         downscaled pictures, - for none. Features are then only searched in the overlapping strips" << endl;
+        cout << "MAX_KEYPOINTS: keypoints kept per picture, the strongest ones (default: all, 0 too)" << endl;
+        cout << "ALIGN_SCALE: translations are estimated on the pictures scaled by ALIGN_SCALE (e.g. 0.25), default 1" << endl;
+        cout << "REFINE_WINDOW: +- pixels of the full resolution refinement of each translation, default 2 / ALIGN_SCALE, 0 disables it" << endl;
+        cout << "PHASE_RESPONSE: pairs are first aligned by phase correlation, SIFT only runs on those whose peak response" << endl;
+        cout << "                is below PHASE_RESPONSE (e.g. 0.1), default 0: SIFT only" << endl;
+        cout << "OUTPUT: .tif file the panoramic image is written to (BigTIFF beyond 4 GB) instead of being shown. It is" << endl;
+        cout << "        composed in a memory-mapped file next to OUTPUT, so it doesn't need to fit in memory" << endl;
 
         return 1;
     }
@@ -38,19 +35,63 @@ int main(int argc, char* argv[]) {
     double fov = atof(argv[2]);
     float match_filter_ratio = atof(argv[3]);
 
-    Mat panoramic = PanoramicImage(img_folder_path, fov)
+    string overlap = argc > 4 ? argv[4] : "";
+    int max_keypoints = argc > 5 ? atoi(argv[5]) : 0;
+    double align_scale = argc > 6 ? atof(argv[6]) : 1;
+    // also rejects NaN and what atof can't parse (0)
+    if (!(align_scale > 0 && align_scale <= 1)) {
+        cout << "ALIGN_SCALE must be a number in (0, 1], got " << argv[6] << endl;
+        return 1;
+    }
+    int refine_window = argc > 7 ? atoi(argv[7]) : (align_scale < 1 ? (int) ceil(2 / align_scale) : 0);
+    double phase_response = argc > 8 ? atof(argv[8]) : 0;
+    string output = argc > 9 ? argv[9] : "";
+
+    PanoramicImage panoramic_image(img_folder_path, fov);
+    panoramic_image.limitKeypoints(max_keypoints);
+    panoramic_image.usePhaseCorrelation(phase_response);
+    if (align_scale < 1)
+        panoramic_image.alignAtScale(align_scale, refine_window);
+    if (overlap == "auto")
+        panoramic_image.estimateOverlap();
+    else if (!overlap.empty() && overlap != "-")
+        panoramic_image.useOverlapPrior(atof(overlap.c_str()));
+
+    panoramic_image
         .findKeypoints()
         .findMatches()
-        .refineAndComputeTranslations(match_filter_ratio)
-        .composePanoramicImage();
+        .refineAndComputeTranslations(match_filter_ratio);
+
+    if (!output.empty()) {
+        size_t slash = output.find_last_of("/\\");
+        string directory = slash == string::npos ? "." : output.substr(0, slash);
+        if (directory.empty())
+            directory = "/";
+
+        TiledCanvas canvas;
+        if (!panoramic_image.composePanoramicImage(canvas, directory)) {
+            cerr << "Can't create the canvas in " << directory << endl;
+            return 1;
+        }
+        equalizeHSV(canvas);
+        if (!canvas.writeTiff(output)) {
+            cerr << "Can't write " << output << endl;
+            return 1;
+        }
+        cout << "Panoramic image (" << canvas.size() << ") written to " << output << endl;
+        return 0;
+    }
+
+    Mat panoramic = panoramic_image.composePanoramicImage();
 
-    panoramic = equalize(panoramic);
+    equalizeHSV(panoramic, panoramic);
 
-    namedWindow("Panoramic", WINDOW_NORMAL);
-    imshow("Panoramic", panoramic);
+    // with CVLAB_TILE_CACHE set the tiles go to disk and the panorama doesn't need to stay in memory
+    TiledViewer viewer("Panoramic");
+    viewer.show(panoramic);
+    panoramic.release();
 
-    waitKey(0);
-    destroyAllWindows();
+    viewer.waitKey(0);
 
     return 0;
 }
@@ -0,0 +1,105 @@
+#include <atomic>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <opencv2/core.hpp>
+#include "vision_core/object_model_registry.h"
+#include "vision_core/tracking_session.h"
+
+using namespace std;
+using namespace cv;
+
+// CONFIG
+Size GAUSSIAN_BLUR_SIZE(3,3);
+float GAUSSIAN_SIGMA = 1;
+
+/**
+ * @return file name of path without folders and extension
+ */
+string baseName(const string &path) {
+    size_t slash = path.find_last_of("/\\");
+    string name = slash == string::npos ? path : path.substr(slash + 1);
+    size_t dot = name.find_last_of('.');
+    return dot == string::npos ? name : name.substr(0, dot);
+}
+
+/**
+ * Runs the Lab6 tracker over many videos, at most JOBS at a time.
+ * The object model is loaded (or extracted) once and shared read-only by all the sessions,
+ * each worker thread reuses its own session for the videos it picks up.
+ */
+int main(int argc, char* argv[]) {
+
+    if (argc < 4 || argc > 6) {
+        cout << "USAGE: $" << argv[0] << " VIDEO_LIST OBJECTS_PATH OUTPUT_DIR [JOBS] [MODEL_PATH]" << endl;
+        cout << "VIDEO_LIST: text file with the path of a video on each line." << endl;
+        cout << "OBJECTS_PATH: path to the folder containing the objects to detect on the videos." << endl;
+        cout << "OUTPUT_DIR: existing folder where the annotated videos are written." << endl;
+        cout << "JOBS: number of videos processed concurrently, default 2." << endl;
+        cout << "MODEL_PATH: optional file caching the objects features, see Lab6." << endl;
+        return 1;
+    }
+
+    string list_path(argv[1]);
+    string obj_images_folder(argv[2]);
+    string output_dir(argv[3]);
+    int jobs = argc > 4 ? max(1, atoi(argv[4])) : 2;
+    string model_path(argc > 5 ? argv[5] : "");
+
+    vector<string> videos;
+    ifstream list(list_path);
+    for (string line; getline(list, line);) {
+        if (!line.empty())
+            videos.push_back(line);
+    }
+
+    if (videos.empty()) {
+        cout << "No videos found in " << list_path << endl;
+        return 1;
+    }
+
+    ObjectModelRegistry obj_models;
+    obj_models.loadOrAddImages(model_path, obj_images_folder, GAUSSIAN_BLUR_SIZE, GAUSSIAN_SIGMA);
+
+    TrackingConfig config;
+    config.verbose = false;
+
+    atomic<int> next_video(0);
+    atomic<int> failed_videos(0);
+    atomic<int> total_frames(0);
+    mutex log_mutex;
+    int64 start = getTickCount();
+
+    auto worker = [&]() {
+        TrackingSession session(obj_models, config);
+
+        for (int i = next_video++; i < videos.size(); i = next_video++) {
+            string output_path = output_dir + "/" + baseName(videos[i]) + "_result.avi";
+            SessionStats stats;
+            bool ok = session.run(videos[i], output_path, stats);
+
+            total_frames += stats.frames;
+            failed_videos += !ok;
+
+            lock_guard<mutex> lock(log_mutex);
+            if (ok)
+                cout << videos[i] << ": " << stats.frames << " frames, " << stats.frames / stats.seconds << " fps, "
+                     << stats.lost_objects << " objects lost" << endl;
+            else
+                cout << videos[i] << ": can't open the video" << endl;
+        }
+    };
+
+    vector<thread> workers;
+    for (int j = 0; j < min(jobs, (int) videos.size()); j++)
+        workers.emplace_back(worker);
+    for (auto &w : workers)
+        w.join();
+
+    double elapsed = (getTickCount() - start) / getTickFrequency();
+    cout << "Processed " << videos.size() - failed_videos << "/" << videos.size() << " videos, "
+         << total_frames << " frames in " << elapsed << " s (" << total_frames / elapsed << " fps)" << endl;
+
+    return failed_videos ? 1 : 0;
+}
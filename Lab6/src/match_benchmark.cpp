@@ -0,0 +1,110 @@
+#include <algorithm>
+#include <iostream>
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+#include "vision_core/object_model_registry.h"
+
+using namespace std;
+using namespace cv;
+
+/**
+ * Benchmark of the object detection matching step: one BFMatcher query per object (ObjectModelRegistry::match)
+ * against one query of the combined index (ObjectModelRegistry::matchAll), sweeping the number of registered objects.
+ * Objects and frame are synthetic and generated with a fixed seed, so no dataset is needed.
+ */
+
+const int SWEEP[] = { 1, 2, 5, 10, 20, 50, 100 };
+const int REPETITIONS = 5;
+const Size OBJ_SIZE(256, 256);
+const Size FRAME_SIZE(1280, 720);
+const int OBJS_IN_FRAME = 6;
+
+/**
+ * Smooth random background with random shapes on top, which gives SIFT plenty of blobs and corners.
+ */
+Mat syntheticImage(RNG &rng, Size size, int shapes) {
+    Mat small(size.height / 16, size.width / 16, CV_8UC3);
+    rng.fill(small, RNG::UNIFORM, 0, 256);
+
+    Mat img;
+    resize(small, img, size, 0, 0, INTER_CUBIC);
+
+    for (int i = 0; i < shapes; i++) {
+        Point p(rng.uniform(0, size.width), rng.uniform(0, size.height));
+        Scalar color(rng.uniform(0, 256), rng.uniform(0, 256), rng.uniform(0, 256));
+        int s = rng.uniform(4, 24);
+
+        if (i % 2)
+            circle(img, p, s, color, -1);
+        else
+            rectangle(img, Rect(p.x, p.y, s, rng.uniform(4, 24)), color, -1);
+    }
+
+    return img;
+}
+
+double medianMs(vector<double> times) {
+    sort(times.begin(), times.end());
+    return times[times.size() / 2];
+}
+
+int main() {
+    RNG rng(42);
+    int max_objects = *max_element(begin(SWEEP), end(SWEEP));
+
+    vector<Mat> objects;
+    for (int i = 0; i < max_objects; i++)
+        objects.push_back(syntheticImage(rng, OBJ_SIZE, 60));
+
+    // frame showing a few of the objects over a synthetic background
+    Mat frame = syntheticImage(rng, FRAME_SIZE, 400);
+    for (int i = 0; i < OBJS_IN_FRAME; i++) {
+        Point p(rng.uniform(0, FRAME_SIZE.width - OBJ_SIZE.width), rng.uniform(0, FRAME_SIZE.height - OBJ_SIZE.height));
+        objects[i].copyTo(frame(Rect(p, OBJ_SIZE)));
+    }
+
+    cout << "objects,per_object_ms,combined_ms,speedup,per_object_matches,combined_matches" << endl;
+
+    for (int n_objects : SWEEP) {
+        ObjectModelRegistry registry;
+        for (int i = 0; i < n_objects; i++)
+            registry.add("obj" + to_string(i), objects[i]);
+        registry.buildIndex();
+
+        vector<KeyPoint> frame_keypoints;
+        Mat frame_descriptors;
+        registry.extract(frame, frame_keypoints, frame_descriptors);
+
+        vector<double> per_object_times, combined_times;
+        size_t per_object_matches = 0, combined_matches = 0;
+
+        for (int r = 0; r < REPETITIONS; r++) {
+            vector<DMatch> matches;
+            per_object_matches = 0;
+
+            int64 start = getTickCount();
+            for (int i = 0; i < n_objects; i++) {
+                registry.match(i, frame_descriptors, matches);
+                per_object_matches += matches.size();
+            }
+            per_object_times.push_back((getTickCount() - start) * 1000. / getTickFrequency());
+
+            vector<vector<DMatch>> all_matches;
+            combined_matches = 0;
+
+            start = getTickCount();
+            registry.matchAll(frame_descriptors, all_matches);
+            combined_times.push_back((getTickCount() - start) * 1000. / getTickFrequency());
+
+            for (const auto &m : all_matches)
+                combined_matches += m.size();
+        }
+
+        double per_object_ms = medianMs(per_object_times);
+        double combined_ms = medianMs(combined_times);
+        cout << n_objects << "," << per_object_ms << "," << combined_ms << "," << per_object_ms / combined_ms << ","
+             << per_object_matches << "," << combined_matches << endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,163 @@
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <numeric>
+#include <opencv2/core/utility.hpp>
+#include "bench_harness.h"
+#include "vision_core/pixel_kernels.h"
+
+#ifndef BENCH_GIT_REVISION
+#define BENCH_GIT_REVISION "unknown"
+#endif
+
+using namespace std;
+using namespace cv;
+
+BenchState::BenchState(Size resolution, double min_seconds, int min_iterations, int max_iterations)
+    : size(resolution), minSeconds(min_seconds), minIterations(min_iterations), maxIterations(max_iterations) {
+}
+
+bool BenchState::next() {
+    int64 now = getTickCount();
+
+    // iteration 0 is the warm-up
+    if (iteration > 0) {
+        double seconds = (now - lastTick) / getTickFrequency();
+        times.push_back(seconds * 1000);
+        elapsed += seconds;
+    }
+    iteration++;
+
+    int measured = (int) times.size();
+    if (measured >= maxIterations || (measured >= minIterations && elapsed >= minSeconds))
+        return false;
+
+    lastTick = getTickCount();
+    return true;
+}
+
+string BenchResult::key() const {
+    return name + "@" + to_string(resolution.width) + "x" + to_string(resolution.height);
+}
+
+void BenchRunner::add(const string &name, const vector<Size> &resolutions, Benchmark benchmark) {
+    entries.push_back({ name, resolutions, benchmark });
+}
+
+static double percentile(const vector<double> &sorted, double p) {
+    return sorted[min(sorted.size() - 1, (size_t) (p * (sorted.size() - 1) + 0.5))];
+}
+
+const vector<BenchResult>& BenchRunner::run() {
+    if (options.threads >= 0)
+        setNumThreads(options.threads);
+
+    results.clear();
+    for (const auto &entry : entries) {
+        if (entry.name.find(options.filter) == string::npos)
+            continue;
+
+        for (const auto &resolution : entry.resolutions) {
+            BenchState state(resolution, options.minSeconds, options.minIterations, options.maxIterations);
+            entry.benchmark(state);
+
+            vector<double> times = state.timesMs();
+            if (times.empty())
+                continue;
+            sort(times.begin(), times.end());
+
+            BenchResult r;
+            r.name = entry.name;
+            r.resolution = resolution;
+            r.iterations = times.size();
+            r.medianMs = percentile(times, 0.5);
+            r.meanMs = accumulate(times.begin(), times.end(), 0.0) / times.size();
+            r.minMs = times.front();
+            r.p95Ms = percentile(times, 0.95);
+            r.counters = state.counterValues();
+            results.push_back(r);
+
+            printf("%-34s %5dx%-5d %6d it  median %10.3f ms  p95 %10.3f ms\n", r.name.c_str(),
+                   resolution.width, resolution.height, r.iterations, r.medianMs, r.p95Ms);
+            fflush(stdout);
+        }
+    }
+
+    return results;
+}
+
+void BenchRunner::writeJson(const string &path) const {
+    FileStorage fs(path, FileStorage::WRITE | FileStorage::FORMAT_JSON);
+
+    fs << "context" << "{";
+    fs << "revision" << BENCH_GIT_REVISION;
+    fs << "opencv" << CV_VERSION;
+    fs << "threads" << getNumThreads();
+    // results are only comparable between runs on machines with the same features
+    fs << "cpu_features" << "[";
+    const pair<int, const char*> features[] = {
+            { CV_CPU_SSE4_1, "SSE4.1" }, { CV_CPU_AVX2, "AVX2" }, { CV_CPU_AVX512_SKX, "AVX512_SKX" }, { CV_CPU_NEON, "NEON" } };
+    for (const auto &f : features) {
+        if (checkHardwareSupport(f.first))
+            fs << f.second;
+    }
+    fs << "]";
+    fs << "kernel_isa" << kernelIsaName(activeKernelIsa());
+    fs << "min_seconds" << options.minSeconds;
+    fs << "}";
+
+    fs << "benchmarks" << "[";
+    for (const auto &r : results) {
+        fs << "{";
+        fs << "key" << r.key();
+        fs << "name" << r.name;
+        fs << "width" << r.resolution.width;
+        fs << "height" << r.resolution.height;
+        fs << "iterations" << r.iterations;
+        fs << "median_ms" << r.medianMs;
+        fs << "mean_ms" << r.meanMs;
+        fs << "min_ms" << r.minMs;
+        fs << "p95_ms" << r.p95Ms;
+        fs << "counters" << "{";
+        for (const auto &c : r.counters)
+            fs << c.first << c.second;
+        fs << "}";
+        fs << "}";
+    }
+    fs << "]";
+}
+
+bool BenchRunner::compare(const string &baseline_path, double tolerance, int &regressions) const {
+    FileStorage fs;
+    try {
+        fs.open(baseline_path, FileStorage::READ);
+    } catch (const cv::Exception &) {
+        // malformed file, reported below as unreadable
+    }
+    if (!fs.isOpened() || !fs["benchmarks"].isSeq()) {
+        cout << "Can't read baseline " << baseline_path << endl;
+        return false;
+    }
+
+    map<string, double> baseline;
+    for (const auto &node : fs["benchmarks"])
+        baseline[(string) node["key"]] = (double) node["median_ms"];
+
+    cout << endl << "Compared with " << baseline_path << " (revision " << (string) fs["context"]["revision"] << ")" << endl;
+
+    regressions = 0;
+    for (const auto &r : results) {
+        auto it = baseline.find(r.key());
+        if (it == baseline.end())
+            continue;
+
+        double ratio = r.medianMs / it->second;
+        bool regression = ratio > 1 + tolerance;
+        regressions += regression;
+
+        printf("%-46s %10.3f -> %10.3f ms  x%.2f%s\n", r.key().c_str(), it->second, r.medianMs, ratio,
+               regression ? "  REGRESSION" : "");
+    }
+
+    return true;
+}
@@ -0,0 +1,113 @@
+#ifndef BENCH_BENCH_HARNESS_H
+#define BENCH_BENCH_HARNESS_H
+
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+#include <opencv2/core.hpp>
+
+/**
+ * Timing loop handed to a benchmark. The benchmark does its setup, then times its kernel with
+ *
+ *     while (state.next())
+ *         kernel();
+ *
+ * The first iteration is a warm-up (buffers allocation, caches) and is not measured.
+ */
+class BenchState {
+public:
+    BenchState(cv::Size resolution, double min_seconds, int min_iterations, int max_iterations);
+
+    cv::Size resolution() const { return size; }
+
+    /**
+     * @return true while the kernel has to be run again
+     */
+    bool next();
+
+    /**
+     * Attaches a value to the result (e.g. keypoints found), to spot kernels doing less work instead of getting faster.
+     */
+    void setCounter(const std::string &name, double value) { counters[name] = value; }
+
+    const std::vector<double>& timesMs() const { return times; }
+    const std::map<std::string, double>& counterValues() const { return counters; }
+
+private:
+    cv::Size size;
+    double minSeconds;
+    int minIterations;
+    int maxIterations;
+
+    int64 lastTick = 0;
+    int iteration = -1;
+    double elapsed = 0;
+    std::vector<double> times;
+    std::map<std::string, double> counters;
+};
+
+struct BenchResult {
+    std::string name;
+    cv::Size resolution;
+    int iterations = 0;
+    double medianMs = 0;
+    double meanMs = 0;
+    double minMs = 0;
+    double p95Ms = 0;
+    std::map<std::string, double> counters;
+
+    // name@WIDTHxHEIGHT, the key used to compare results of different runs
+    std::string key() const;
+};
+
+struct BenchOptions {
+    std::string filter;
+    double minSeconds = 0.5;
+    int minIterations = 5;
+    int maxIterations = 1000;
+    int threads = -1;
+};
+
+/**
+ * Runs a set of benchmarks, each at several resolutions, and writes the results as JSON.
+ */
+class BenchRunner {
+public:
+    typedef std::function<void(BenchState&)> Benchmark;
+
+    explicit BenchRunner(BenchOptions options) : options(options) {}
+
+    void add(const std::string &name, const std::vector<cv::Size> &resolutions, Benchmark benchmark);
+
+    /**
+     * Runs the benchmarks whose name contains options.filter, printing a line per result.
+     */
+    const std::vector<BenchResult>& run();
+
+    /**
+     * Writes the results and the run context (revision, OpenCV version, threads, CPU features).
+     */
+    void writeJson(const std::string &path) const;
+
+    /**
+     * Compares the results with a JSON written by a previous run.
+     * @param regressions receives the number of results whose median is more than tolerance (relative) slower
+     * than the baseline
+     * @return false if the baseline is missing or isn't a results file, regressions is then not set
+     */
+    bool compare(const std::string &baseline_path, double tolerance, int &regressions) const;
+
+private:
+    struct Entry {
+        std::string name;
+        std::vector<cv::Size> resolutions;
+        Benchmark benchmark;
+    };
+
+    BenchOptions options;
+    std::vector<Entry> entries;
+    std::vector<BenchResult> results;
+};
+
+#endif //BENCH_BENCH_HARNESS_H
@@ -0,0 +1,106 @@
+#include <iostream>
+#include "kernel_check.h"
+#include "vision_core/pixel_kernels.h"
+
+using namespace cv;
+using namespace std;
+
+// widths around the vector sizes (16, 32, 64 pixels) and their tails
+static const int WIDTHS[] = { 1, 3, 15, 16, 17, 31, 32, 33, 63, 64, 65, 127, 200, 641 };
+
+static bool sameMat(const Mat &a, const Mat &b) {
+    return a.size() == b.size() && a.type() == b.type() && norm(a, b, NORM_INF) == 0;
+}
+
+static int report(const string &kernel, KernelIsa isa, int width) {
+    cout << "MISMATCH " << kernel << " " << kernelIsaName(isa) << " width " << width << endl;
+    return 1;
+}
+
+static int checkColorRange(RNG &rng, const vector<KernelIsa> &isas) {
+    int failures = 0;
+
+    for (int width : WIDTHS) {
+        Mat image(7, width + 5, CV_8UC3);
+        rng.fill(image, RNG::UNIFORM, 0, 256);
+        // ROI, so that rows are not continuous
+        Mat src = image(Rect(2, 1, width, 5));
+
+        vector<pair<Vec3b, Vec3b>> ranges = {
+                { Vec3b(0, 0, 0), Vec3b(255, 255, 255) },
+                { Vec3b(1, 1, 1), Vec3b(0, 0, 0) },
+                { Vec3b(0, 0, 0), Vec3b(0, 0, 0) },
+                { Vec3b(255, 255, 255), Vec3b(255, 255, 255) } };
+        for (int i = 0; i < 8; i++) {
+            Vec3b lower, upper;
+            for (int c = 0; c < 3; c++) {
+                int a = rng.uniform(0, 256), b = rng.uniform(0, 256);
+                lower[c] = (uchar) min(a, b);
+                upper[c] = (uchar) max(a, b);
+            }
+            ranges.emplace_back(lower, upper);
+        }
+
+        for (const auto &range : ranges) {
+            Mat reference, mask;
+            setKernelIsa(KERNEL_SCALAR);
+            colorRangeMask(src, reference, range.first, range.second);
+
+            for (KernelIsa isa : isas) {
+                setKernelIsa(isa);
+                colorRangeMask(src, mask, range.first, range.second);
+                if (!sameMat(reference, mask))
+                    failures += report("colorRangeMask", isa, width);
+            }
+        }
+    }
+
+    return failures;
+}
+
+static int checkGather(RNG &rng, const vector<KernelIsa> &isas) {
+    int failures = 0;
+
+    for (int width : WIDTHS) {
+        Mat src(9, width, CV_8UC3);
+        rng.fill(src, RNG::UNIFORM, 0, 256);
+
+        Mat offsets(4, width, CV_32SC1);
+        for (int row = 0; row < offsets.rows; row++) {
+            for (int col = 0; col < offsets.cols; col++)
+                offsets.at<int>(row, col) = rng.uniform(0, (int) src.total()) * 3;
+        }
+        // the last pixel of src, the SIMD versions must not read past it
+        offsets.at<int>(0, width - 1) = ((int) src.total() - 1) * 3;
+        offsets.at<int>(3, 0) = ((int) src.total() - 1) * 3;
+
+        Mat reference, dst;
+        setKernelIsa(KERNEL_SCALAR);
+        gatherPixels(src, offsets, reference);
+
+        for (KernelIsa isa : isas) {
+            setKernelIsa(isa);
+            gatherPixels(src, offsets, dst);
+            if (!sameMat(reference, dst))
+                failures += report("gatherPixels", isa, width);
+        }
+    }
+
+    return failures;
+}
+
+int checkPixelKernels() {
+    const KernelIsa active = activeKernelIsa();
+    vector<KernelIsa> isas = supportedKernelIsas();
+
+    RNG rng(12345);
+    int failures = checkColorRange(rng, isas) + checkGather(rng, isas);
+    setKernelIsa(active);
+
+    cout << "Pixel kernels checked against scalar:";
+    for (KernelIsa isa : isas)
+        cout << " " << kernelIsaName(isa);
+    cout << (failures ? ", FAILED" : ", all equal") << endl;
+
+    return failures;
+}
@@ -0,0 +1,12 @@
+#ifndef BENCH_KERNEL_CHECK_H
+#define BENCH_KERNEL_CHECK_H
+
+/**
+ * Runs every pixel kernel with each instruction set supported by the machine and compares the output
+ * with the scalar version on random inputs: odd widths, ROIs, empty and full ranges, offsets up to the
+ * last pixel of the image. Prints the mismatches.
+ * @return number of kernels and instruction sets giving a different result, 0 if all agree
+ */
+int checkPixelKernels();
+
+#endif //BENCH_KERNEL_CHECK_H
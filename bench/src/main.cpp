@@ -0,0 +1,526 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <opencv2/calib3d.hpp>
+#include <opencv2/core.hpp>
+#include <opencv2/core/utils/filesystem.hpp>
+#include <opencv2/features2d.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+#include <opencv2/video/tracking.hpp>
+#include "bench_harness.h"
+#include "kernel_check.h"
+#include "synthetic.h"
+#include "vision_core/calibration_coverage.h"
+#include "vision_core/color_segmenter.h"
+#include "vision_core/edge_detector.h"
+#include "vision_core/equalization.h"
+#include "vision_core/features.h"
+#include "vision_core/filters.h"
+#include "vision_core/image_io.h"
+#include "vision_core/panoramic_image.h"
+#include "vision_core/phase_correlation.h"
+#include "vision_core/pixel_kernels.h"
+#include "vision_core/projection.h"
+#include "vision_core/region_stats.h"
+#include "vision_core/stream_detector_params.h"
+#include "vision_core/tiled_canvas.h"
+#include "vision_core/translation_estimator.h"
+
+using namespace std;
+using namespace cv;
+
+const Size VGA(640, 480);
+const Size HD(1280, 720);
+const Size FHD(1920, 1080);
+const Size UHD(3840, 2160);
+
+// Same seed for every kernel, inputs never change between runs
+const uint64 SEED = 42;
+
+void addBenchmarks(BenchRunner &runner) {
+
+    // Lab5: projection of each picture on a cylinder, 66 degrees FOV
+    runner.add("lab5.cylindrical_proj", { VGA, HD, FHD }, [](BenchState &state) {
+        Mat img = synthetic::texturedImage(state.resolution(), SEED);
+        CylindricalProjector projector;
+        Mat result;
+        while (state.next())
+            projector.project(img, result, 33);
+    });
+
+    // the dispatched pixel kernels once per instruction set of the machine, to see what each level brings
+    for (KernelIsa isa : supportedKernelIsas()) {
+        string suffix = string(".") + kernelIsaName(isa);
+
+        runner.add("kernels.color_range" + suffix, { VGA, FHD }, [isa](BenchState &state) {
+            Mat img = synthetic::texturedImage(state.resolution(), SEED);
+            Mat mask;
+            KernelIsa previous = activeKernelIsa();
+            setKernelIsa(isa);
+            while (state.next())
+                colorRangeMask(img, mask, Vec3b(0, 80, 130), Vec3b(114, 234, 255));
+            setKernelIsa(previous);
+            state.setCounter("in_range", countNonZero(mask));
+        });
+
+        runner.add("kernels.cylindrical_gather" + suffix, { VGA, FHD }, [isa](BenchState &state) {
+            Mat img = synthetic::texturedImage(state.resolution(), SEED);
+            CylindricalProjector projector;
+            Mat result;
+            KernelIsa previous = activeKernelIsa();
+            setKernelIsa(isa);
+            while (state.next())
+                projector.project(img, result, 33);
+            setKernelIsa(previous);
+        });
+    }
+
+    runner.add("lab5.equalize_hsv", { VGA, HD, FHD, UHD }, [](BenchState &state) {
+        Mat img = synthetic::texturedImage(state.resolution(), SEED);
+        Mat result;
+        while (state.next())
+            equalizeHSV(img, result);
+    });
+
+    // Lab1: colour segmentation of a whole frame, distance to the reference in BGR (intervals) and HSV (tables)
+    runner.add("lab1.color_segment_bgr", { VGA, FHD, UHD }, [](BenchState &state) {
+        Mat img = synthetic::texturedImage(state.resolution(), SEED);
+        ColorSegmenter segmenter;
+        segmenter.setReference(Vec3b(35, 155, 205), Vec3i::all(80));
+        while (state.next())
+            segmenter.segment(img);
+        state.setCounter("segmented", countNonZero(segmenter.segment(img)));
+    });
+
+    runner.add("lab1.color_segment_hsv", { VGA, FHD, UHD }, [](BenchState &state) {
+        Mat img = synthetic::texturedImage(state.resolution(), SEED);
+        ColorSegmenter segmenter;
+        segmenter.setReference(Vec3b(5, 150, 200), Vec3i(15, 80, 80), ColorSegmenter::SEGMENT_HSV);
+        while (state.next())
+            segmenter.segment(img);
+        state.setCounter("segmented", countNonZero(segmenter.segment(img)));
+    });
+
+    // Lab1: statistics of the clicked regions, building the integral images then 1000 random rectangles
+    runner.add("lab1.region_stats_build", { VGA, FHD, UHD }, [](BenchState &state) {
+        Mat img = synthetic::texturedImage(state.resolution(), SEED);
+        RegionStats stats;
+        while (state.next())
+            stats.build(img);
+    });
+
+    runner.add("lab1.region_stats_query", { FHD, UHD }, [](BenchState &state) {
+        Mat img = synthetic::texturedImage(state.resolution(), SEED);
+        RegionStats stats(img);
+        RNG rng(SEED);
+        vector<Rect> rects(1000);
+        for (Rect &r : rects) {
+            Point tl(rng.uniform(0, img.cols), rng.uniform(0, img.rows));
+            r = Rect(tl, Size(rng.uniform(1, img.cols), rng.uniform(1, img.rows)));
+        }
+
+        Scalar mean, variance;
+        while (state.next()) {
+            for (const Rect &r : rects)
+                stats.query(r, mean, variance);
+        }
+        state.setCounter("queries", rects.size());
+    });
+
+    // Lab3: the three filters with kernels in the middle of the trackbars ranges
+    runner.add("lab3.median_filter", { VGA, HD, FHD }, [](BenchState &state) {
+        Mat img = synthetic::texturedImage(state.resolution(), SEED);
+        MedianFilter filter(img, 7);
+        while (state.next())
+            filter.doFilter();
+    });
+
+    runner.add("lab3.gaussian_filter", { VGA, HD, FHD }, [](BenchState &state) {
+        Mat img = synthetic::texturedImage(state.resolution(), SEED);
+        GaussianFilter filter(img, 15, 5);
+        while (state.next())
+            filter.doFilter();
+    });
+
+    runner.add("lab3.bilateral_filter", { VGA, HD }, [](BenchState &state) {
+        Mat img = synthetic::texturedImage(state.resolution(), SEED);
+        BilateralFilter filter(img, 50, 3);
+        while (state.next())
+            filter.doFilter();
+    });
+
+    // Lab4: edge detection alone and the whole lines + circles chain with the tuned parameters
+    runner.add("lab4.canny", { VGA, HD, FHD, UHD }, [](BenchState &state) {
+        Mat img = synthetic::roadImage(state.resolution(), SEED);
+        StreamDetectorParams params;
+        EdgeDetector detector;
+        Mat edges;
+        while (state.next())
+            detector.detect(img, edges, params.minThreshold, params.ratio * params.minThreshold);
+        state.setCounter("edge_pixels", countNonZero(edges));
+    });
+
+    runner.add("lab4.canny_hough", { VGA, HD, FHD }, [](BenchState &state) {
+        Mat img = synthetic::roadImage(state.resolution(), SEED);
+        StreamDetectorParams params;
+        EdgeDetector detector;
+        Mat edges;
+        vector<Vec2f> lines;
+        vector<Vec3f> circles;
+        while (state.next()) {
+            detector.detect(img, edges, params.minThreshold, params.ratio * params.minThreshold);
+            HoughLines(edges, lines, params.rhoAccumulator, params.thetaAccumulator * CV_PI / 180, params.threshold);
+            HoughCircles(edges, circles, HOUGH_GRADIENT, 1, edges.rows / 4, 100, params.circleAccThreshold, 0, params.circleMaxRadius);
+        }
+        state.setCounter("lines", lines.size());
+        state.setCounter("circles", circles.size());
+    });
+
+    // Lab5: features and matches of a sweep of 5 pictures with 30% overlap, over the whole pictures,
+    // with the overlap given, and with the overlap estimated at low resolution (estimation included)
+    const pair<string, double> sweep_modes[] = { { "full", 0 }, { "overlap", 0.3 }, { "auto", -1 } };
+    for (const auto &mode : sweep_modes) {
+        runner.add("lab5.sweep_features." + mode.first, { VGA, HD }, [mode](BenchState &state) {
+            vector<Mat> frames = synthetic::sweep(state.resolution(), 5, 0.3, SEED);
+            size_t keypoints = 0, matches = 0;
+            while (state.next()) {
+                PanoramicImage panoramic(frames);
+                if (mode.second > 0)
+                    panoramic.useOverlapPrior(mode.second);
+                else if (mode.second < 0)
+                    panoramic.estimateOverlap();
+                panoramic.findKeypoints().findMatches();
+
+                keypoints = matches = 0;
+                for (const auto &kp : panoramic.keypoints)
+                    keypoints += kp.size();
+                for (const auto &m : panoramic.matches)
+                    matches += m.size();
+            }
+            state.setCounter("keypoints", keypoints);
+            state.setCounter("matches", matches);
+        });
+    }
+
+    // Lab5: whole alignment of the same sweep at full resolution, and at 1/4 with the full resolution refinement
+    const pair<string, double> align_modes[] = { { "full", 1 }, { "low_res", 0.25 } };
+    for (const auto &mode : align_modes) {
+        runner.add("lab5.sweep_align." + mode.first, { VGA, HD, FHD }, [mode](BenchState &state) {
+            vector<Mat> frames = synthetic::sweep(state.resolution(), 5, 0.3, SEED);
+            vector<int> translations;
+            while (state.next()) {
+                PanoramicImage panoramic(frames);
+                if (mode.second < 1)
+                    panoramic.alignAtScale(mode.second, (int) ceil(2 / mode.second));
+                panoramic.findKeypoints().findMatches().refineAndComputeTranslations(3);
+                translations = panoramic.x_translations;
+            }
+            // expected: -0.7 * width for each pair
+            double error = 0;
+            for (int dx : translations)
+                error = max(error, abs(dx + 0.7 * state.resolution().width));
+            state.setCounter("max_error_px", error);
+        });
+    }
+
+    // Lab5: the same sweep at 1/4 aligned by phase correlation on the estimated overlap, SIFT only for weak peaks
+    runner.add("lab5.sweep_align.phase", { VGA, HD, FHD }, [](BenchState &state) {
+        vector<Mat> frames = synthetic::sweep(state.resolution(), 5, 0.3, SEED);
+        vector<int> translations;
+        int phase_pairs = 0;
+        while (state.next()) {
+            PanoramicImage panoramic(frames);
+            panoramic.alignAtScale(0.25, 8).usePhaseCorrelation().estimateOverlap();
+            panoramic.findKeypoints().findMatches().refineAndComputeTranslations(3);
+            translations = panoramic.x_translations;
+            phase_pairs = (int) count(panoramic.phase_aligned.begin(), panoramic.phase_aligned.end(), true);
+        }
+        double error = 0;
+        for (int dx : translations)
+            error = max(error, abs(dx + 0.7 * state.resolution().width));
+        state.setCounter("max_error_px", error);
+        state.setCounter("phase_pairs", phase_pairs);
+    });
+
+    // Lab5: composition and equalization of a sweep in one Mat, then in a canvas mapped on a temporary file
+    // (tile-wise equalization), whose result must be the same
+    const string compose_modes[] = { "mat", "canvas" };
+    for (const auto &mode : compose_modes) {
+        runner.add("lab5.compose." + mode, { VGA, HD }, [mode](BenchState &state) {
+            PanoramicImage panoramic(synthetic::sweep(state.resolution(), 5, 0.3, SEED));
+            panoramic.x_translations.assign(4, -cvRound(0.7 * state.resolution().width));
+
+            string temp = tempfile();
+            string directory = temp.substr(0, temp.find_last_of('/'));
+            Mat result;
+            while (state.next()) {
+                if (mode == "mat") {
+                    equalizeHSV(panoramic.composePanoramicImage(), result);
+                } else {
+                    TiledCanvas canvas;
+                    panoramic.composePanoramicImage(canvas, directory);
+                    equalizeHSV(canvas);
+                    canvas.read(Rect(Point(0, 0), canvas.size()), result);
+                }
+            }
+
+            Mat reference;
+            equalizeHSV(panoramic.composePanoramicImage(), reference);
+            state.setCounter("max_diff", norm(result, reference, NORM_INF));
+        });
+    }
+
+    // Lab5: phase correlation of two frames of the sweep, the first call of a size builds its plan, the others reuse it
+    runner.add("lab5.phase_correlate", { VGA, HD }, [](BenchState &state) {
+        vector<Mat> frames = synthetic::sweep(state.resolution(), 2, 0.3, SEED);
+        PhaseCorrelator correlator;
+        PhaseCorrelation c;
+        while (state.next())
+            c = correlator.correlate(frames[0], frames[1]);
+        state.setCounter("error_px", abs(c.shift.x + 0.7 * state.resolution().width));
+        state.setCounter("response", c.response);
+    });
+
+    // Lab5: translation of the matches of a pair, 40% inliers, the rest random or on a repeated pattern
+    // (resolution = number of matches x 1). Homography RANSAC as before, then the two translation estimators
+    const string estimators[] = { "homography", "vote", "ransac1" };
+    for (const auto &estimator : estimators) {
+        runner.add("lab5.translation_estimate." + estimator, { Size(200, 1), Size(2000, 1) }, [estimator](BenchState &state) {
+            RNG rng(SEED);
+            const Point2f truth(-448.5f, 2.f), pattern(-416.f, 2.f);
+            vector<Point2f> src, dst;
+            for (int i = 0; i < state.resolution().width; i++) {
+                Point2f p(rng.uniform(448.f, 640.f), rng.uniform(0.f, 480.f));
+                int kind = i % 10;
+                Point2f noise(rng.gaussian(0.7), rng.gaussian(0.7));
+                Point2f q = kind < 4 ? p + truth + noise
+                          : kind < 6 ? p + pattern + noise
+                          : Point2f(rng.uniform(0.f, 640.f), rng.uniform(0.f, 480.f));
+                src.push_back(p);
+                dst.push_back(q);
+            }
+
+            TranslationEstimator::Params params;
+            params.method = estimator == "ransac1" ? TranslationEstimator::RANSAC_1PT : TranslationEstimator::VOTE;
+            TranslationEstimator translation(params);
+
+            Point2f found;
+            while (state.next()) {
+                if (estimator == "homography") {
+                    vector<uchar> mask;
+                    findHomography(src, dst, RANSAC, 3, mask);
+                    Point2f sum;
+                    int n = 0;
+                    for (size_t j = 0; j < mask.size(); j++) {
+                        if (mask[j]) {
+                            sum += dst[j] - src[j];
+                            n++;
+                        }
+                    }
+                    found = n ? sum / n : Point2f();
+                } else {
+                    found = translation.estimate(src, dst).translation;
+                }
+            }
+            state.setCounter("error_px", norm(found - truth));
+        });
+    }
+
+    // Lab2: calibration from the board corners of a 30 s video (900 frames) of a slowly moving board, with every
+    // view as a folder of stills would give, then with only the views kept by the coverage-aware selection
+    const string calibration_modes[] = { "all", "selected" };
+    for (const auto &mode : calibration_modes) {
+        runner.add("lab2.calibrate_video." + mode, { VGA, FHD }, [mode](BenchState &state) {
+            const Size image = state.resolution(), board(5, 6);
+            const double f = 0.9 * image.width;
+            Mat camera = (Mat_<double>(3, 3) << f, 0, image.width / 2.0, 0, f, image.height / 2.0, 0, 0, 1);
+            vector<Point3f> world;
+            for (int i = 0; i < board.height; i++) {
+                for (int j = 0; j < board.width; j++)
+                    world.emplace_back(j * 0.11f, i * 0.11f, 0);
+            }
+
+            RNG rng(SEED);
+            vector<vector<Point2f>> views;
+            for (int t = 0; t < 900; t++) {
+                double phase = t / 900.0 * 2 * CV_PI;
+                Vec3d rvec(0.5 * sin(3 * phase), 0.5 * sin(2 * phase + 1), 0.3 * sin(phase));
+                Vec3d tvec(-0.22 + 0.5 * sin(5 * phase), -0.27 + 0.35 * sin(4 * phase + 2), 1.2 + 0.6 * sin(phase + 0.5));
+                vector<Point2f> corners;
+                projectPoints(world, rvec, tvec, camera, noArray(), corners);
+                bool inside = true;
+                for (auto &c : corners) {
+                    c += Point2f(rng.gaussian(0.2), rng.gaussian(0.2));
+                    inside = inside && Rect(Point(0, 0), image).contains(c);
+                }
+                if (inside)
+                    views.push_back(corners);
+            }
+
+            vector<vector<Point2f>> points2d;
+            Mat camera_found, dist;
+            while (state.next()) {
+                points2d.clear();
+                if (mode == "all") {
+                    points2d = views;
+                } else {
+                    CalibrationFrameSelector selector(image, board);
+                    for (const auto &v : views) {
+                        if (selector.wouldAccept(v)) {
+                            selector.add(v);
+                            points2d.push_back(v);
+                        }
+                    }
+                }
+                vector<vector<Point3f>> points3d(points2d.size(), world);
+                vector<Mat> rvecs, tvecs;
+                calibrateCamera(points3d, points2d, image, camera_found, dist, rvecs, tvecs);
+            }
+            state.setCounter("views", points2d.size());
+            state.setCounter("focal_error_px", abs(camera_found.at<double>(0, 0) - f));
+        });
+    }
+
+    // Lab2/Lab5/Lab6: folder of 48 JPEGs decoded one at a time as before, then by the parallel loader at full
+    // resolution, in gray and decoded directly at 1/4
+    const pair<string, int> load_modes[] = {
+        { "serial", IMREAD_COLOR }, { "parallel", IMREAD_COLOR },
+        { "gray", IMREAD_GRAYSCALE }, { "reduced_4", IMREAD_REDUCED_COLOR_4 }
+    };
+    for (const auto &mode : load_modes) {
+        runner.add("io.load_folder." + mode.first, { VGA, FHD }, [mode](BenchState &state) {
+            string folder = tempfile("_images");
+            utils::fs::createDirectories(folder);
+            for (int i = 0; i < 48; i++) {
+                Mat img = synthetic::texturedImage(state.resolution(), SEED + i);
+                imwrite(utils::fs::join(folder, format("%03d.jpg", i)), img);
+            }
+
+            ImageLoadOptions options;
+            options.flags = mode.second;
+            if (mode.first == "serial")
+                options.threads = 1;
+
+            vector<Mat> images;
+            while (state.next())
+                loadImages(utils::fs::join(folder, "*.jpg"), images, nullptr, options);
+            state.setCounter("images", images.size());
+            state.setCounter("width", images.empty() ? 0 : images[0].cols);
+
+            utils::fs::remove_all(folder);
+        });
+    }
+
+    // Lab5/Lab6: SIFT extraction, then cross-checked matching of two overlapping views
+    runner.add("sift.extract", { VGA, HD, FHD }, [](BenchState &state) {
+        Mat img = synthetic::texturedImage(state.resolution(), SEED);
+        Ptr<Feature2D> sift = createSiftDetector();
+        vector<KeyPoint> keypoints;
+        Mat descriptors;
+        while (state.next())
+            sift->detectAndCompute(img, noArray(), keypoints, descriptors);
+        state.setCounter("keypoints", keypoints.size());
+    });
+
+    runner.add("sift.bf_match", { VGA, HD }, [](BenchState &state) {
+        Mat img = synthetic::texturedImage(state.resolution(), SEED);
+        Mat other = synthetic::moved(img, state.resolution().width / 4., 0, 0);
+        Ptr<Feature2D> sift = createSiftDetector();
+        vector<KeyPoint> kp1, kp2;
+        Mat ds1, ds2;
+        sift->detectAndCompute(img, noArray(), kp1, ds1);
+        sift->detectAndCompute(other, noArray(), kp2, ds2);
+
+        BFMatcher matcher(NORM_L2, true);
+        vector<DMatch> matches;
+        while (state.next())
+            matcher.match(ds1, ds2, matches);
+        state.setCounter("matches", matches.size());
+    });
+
+    // Lab6: pyramid of the new frame and LK of the tracked keypoints, Lab6 default window
+    runner.add("lab6.lk_track", { VGA, HD, FHD }, [](BenchState &state) {
+        Mat prev_gray, curr_gray;
+        cvtColor(synthetic::texturedImage(state.resolution(), SEED), prev_gray, COLOR_BGR2GRAY);
+        curr_gray = synthetic::moved(prev_gray, 3, 2, 0.5);
+
+        vector<Point2f> points;
+        goodFeaturesToTrack(prev_gray, points, 500, 0.01, 7);
+
+        Size win(17, 17);
+        int max_level = 3;
+        vector<Mat> prev_pyr, curr_pyr;
+        buildOpticalFlowPyramid(prev_gray, prev_pyr, win, max_level);
+
+        vector<Point2f> moved;
+        vector<uchar> status;
+        vector<float> err;
+        while (state.next()) {
+            buildOpticalFlowPyramid(curr_gray, curr_pyr, win, max_level, true, BORDER_REFLECT_101, BORDER_CONSTANT, false);
+            calcOpticalFlowPyrLK(prev_pyr, curr_pyr, points, moved, status, err, win, max_level);
+        }
+        state.setCounter("points", points.size());
+        state.setCounter("tracked", countNonZero(status));
+    });
+}
+
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+    string json_path = "bench_results.json";
+    string baseline_path;
+    double tolerance = 0.1;
+    bool check = false;
+
+    for (int i = 1; i < argc; i++) {
+        string arg(argv[i]);
+        bool has_value = i + 1 < argc;
+
+        if (arg == "--filter" && has_value)
+            options.filter = argv[++i];
+        else if (arg == "--json" && has_value)
+            json_path = argv[++i];
+        else if (arg == "--baseline" && has_value)
+            baseline_path = argv[++i];
+        else if (arg == "--tolerance" && has_value)
+            tolerance = atof(argv[++i]);
+        else if (arg == "--min-time" && has_value)
+            options.minSeconds = atof(argv[++i]);
+        else if (arg == "--threads" && has_value)
+            options.threads = atoi(argv[++i]);
+        else if (arg == "--check")
+            check = true;
+        else {
+            cout << "USAGE: " << argv[0] << " [--filter NAME] [--json PATH] [--baseline PATH] [--tolerance RATIO] [--min-time SECONDS] [--threads N] [--check]" << endl;
+            cout << "--filter: run only the benchmarks whose name contains NAME" << endl;
+            cout << "--json: where the results are written, default bench_results.json" << endl;
+            cout << "--baseline: results of a previous run (e.g. another commit) to compare with" << endl;
+            cout << "--tolerance: slowdown of the median reported as a regression, default 0.1 (10%)" << endl;
+            cout << "--min-time: minimum measured time per benchmark and resolution, default 0.5 s" << endl;
+            cout << "--threads: OpenCV threads, pin it to compare runs on different machines" << endl;
+            cout << "--check: only compare every instruction set of the pixel kernels with the scalar version" << endl;
+            cout << "Exit code: 2 regressions against the baseline, 3 pixel kernel mismatch, 4 baseline unreadable" << endl;
+            return 1;
+        }
+    }
+
+    if (check)
+        return checkPixelKernels() == 0 ? 0 : 3;
+
+    BenchRunner runner(options);
+    addBenchmarks(runner);
+    runner.run();
+    runner.writeJson(json_path);
+
+    if (!baseline_path.empty()) {
+        int regressions;
+        if (!runner.compare(baseline_path, tolerance, regressions))
+            return 4;
+        if (regressions != 0) {
+            cout << regressions << " regressions" << endl;
+            return 2;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,71 @@
+#include <opencv2/imgproc.hpp>
+#include "synthetic.h"
+
+using namespace cv;
+
+namespace synthetic {
+
+    Mat texturedImage(Size size, uint64 seed) {
+        RNG rng(seed);
+
+        Mat small(max(size.height / 16, 2), max(size.width / 16, 2), CV_8UC3);
+        rng.fill(small, RNG::UNIFORM, 0, 256);
+
+        Mat img;
+        resize(small, img, size, 0, 0, INTER_CUBIC);
+
+        // shape density independent from the resolution
+        int shapes = size.area() / 2000;
+        for (int i = 0; i < shapes; i++) {
+            Point p(rng.uniform(0, size.width), rng.uniform(0, size.height));
+            Scalar color(rng.uniform(0, 256), rng.uniform(0, 256), rng.uniform(0, 256));
+            int s = rng.uniform(4, 24);
+
+            if (i % 2)
+                circle(img, p, s, color, -1);
+            else
+                rectangle(img, Rect(p.x, p.y, s, rng.uniform(4, 24)), color, -1);
+        }
+
+        return img;
+    }
+
+    Mat roadImage(Size size, uint64 seed) {
+        RNG rng(seed);
+
+        Mat img;
+        GaussianBlur(texturedImage(size, seed), img, Size(9, 9), 3);
+
+        // two lane lines converging to the horizon
+        Point horizon(size.width / 2, size.height / 3);
+        line(img, Point(size.width / 8, size.height), horizon, Scalar(255, 255, 255), max(size.width / 200, 2));
+        line(img, Point(size.width * 7 / 8, size.height), horizon, Scalar(255, 255, 255), max(size.width / 200, 2));
+
+        for (int i = 0; i < 3; i++) {
+            Point c(rng.uniform(0, size.width), rng.uniform(0, size.height / 3));
+            circle(img, c, rng.uniform(10, 30), Scalar(0, 0, 255), 3);
+        }
+
+        return img;
+    }
+
+    Mat moved(const Mat &img, double dx, double dy, double angle) {
+        Mat M = getRotationMatrix2D(Point2f(img.cols / 2.f, img.rows / 2.f), angle, 1);
+        M.at<double>(0, 2) += dx;
+        M.at<double>(1, 2) += dy;
+
+        Mat result;
+        warpAffine(img, result, M, img.size(), INTER_LINEAR, BORDER_REFLECT);
+        return result;
+    }
+
+    std::vector<Mat> sweep(Size size, int frames, double overlap, uint64 seed) {
+        int step = (int) round(size.width * (1 - overlap));
+        Mat scene = texturedImage(Size(size.width + step * (frames - 1), size.height), seed);
+
+        std::vector<Mat> result;
+        for (int i = 0; i < frames; i++)
+            result.push_back(scene(Rect(i * step, 0, size.width, size.height)).clone());
+        return result;
+    }
+}
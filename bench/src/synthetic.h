@@ -0,0 +1,34 @@
+#ifndef BENCH_SYNTHETIC_H
+#define BENCH_SYNTHETIC_H
+
+#include <vector>
+#include <opencv2/core.hpp>
+
+/**
+ * Deterministic synthetic inputs: the same seed and size always give the same image,
+ * so results of different commits are measured on the same data and no dataset is needed.
+ */
+namespace synthetic {
+
+    /**
+     * Smooth random background with random filled shapes, giving plenty of corners and blobs (BGR).
+     */
+    cv::Mat texturedImage(cv::Size size, uint64 seed);
+
+    /**
+     * Textured background with a few long straight lines and circles, the kind of scene of Lab4 (BGR).
+     */
+    cv::Mat roadImage(cv::Size size, uint64 seed);
+
+    /**
+     * img translated by (dx, dy) and rotated by angle degrees around its center, to be tracked.
+     */
+    cv::Mat moved(const cv::Mat &img, double dx, double dy, double angle);
+
+    /**
+     * frames pictures of size taken left to right over one scene, consecutive ones sharing overlap of their width.
+     */
+    std::vector<cv::Mat> sweep(cv::Size size, int frames, double overlap, uint64 seed);
+}
+
+#endif //BENCH_SYNTHETIC_H
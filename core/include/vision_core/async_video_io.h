@@ -0,0 +1,102 @@
+#ifndef VISION_CORE_ASYNC_VIDEO_IO_H
+#define VISION_CORE_ASYNC_VIDEO_IO_H
+
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+#include <opencv2/core.hpp>
+#include <opencv2/videoio.hpp>
+#include "vision_core/blocking_queue.h"
+
+/**
+ * Decodes a video on a background thread, prefetching frames into a fixed ring of buffers.
+ * Frames returned by next() are owned by the caller until they are given back with recycle(),
+ * then their buffer is decoded into again: no frame is allocated after the first round of the ring.
+ */
+class AsyncVideoReader {
+public:
+    /**
+     * @param ring_size number of frame buffers, i.e. frames decoded ahead plus frames held by the caller
+     */
+    explicit AsyncVideoReader(const std::string &path, int ring_size = 6);
+    ~AsyncVideoReader();
+
+    bool isOpened() const;
+
+    /**
+     * Blocks until the next frame is decoded.
+     * @return nullptr at the end of the stream
+     */
+    cv::Mat* next();
+
+    /**
+     * Gives back a frame returned by next(), its buffer will be reused for decoding.
+     */
+    void recycle(cv::Mat *frame);
+
+    // seconds spent by the reader thread decoding
+    double decodeSeconds() const;
+    // seconds spent by the caller blocked in next()
+    double waitSeconds() const;
+
+private:
+    cv::VideoCapture cap;
+    std::vector<cv::Mat> ring;
+    BlockingQueue<cv::Mat*> free_frames;
+    BlockingQueue<cv::Mat*> ready_frames;
+    std::thread reader;
+
+    double decodeTime = 0;
+    double waitTime = 0;
+
+    void loop();
+};
+
+/**
+ * Encodes frames on a background thread.
+ * write() only queues the frame and returns, the frame is handed to its recycle function once encoded.
+ */
+class AsyncVideoWriter {
+public:
+    using Recycle = std::function<void(cv::Mat*)>;
+
+    AsyncVideoWriter() = default;
+    ~AsyncVideoWriter();
+
+    /**
+     * Same parameters of cv::VideoWriter::open.
+     */
+    bool open(const std::string &path, int fourcc, double fps, cv::Size frame_size);
+
+    bool isOpened() const;
+
+    /**
+     * Queues frame for encoding, the frame must not be modified until recycle(frame) is called.
+     */
+    void write(cv::Mat *frame, Recycle recycle);
+
+    /**
+     * Waits for the queued frames to be encoded and closes the file.
+     */
+    void release();
+
+    // seconds spent by the writer thread encoding
+    double encodeSeconds() const;
+
+private:
+    struct Job {
+        cv::Mat *frame;
+        Recycle recycle;
+    };
+
+    cv::VideoWriter video;
+    BlockingQueue<Job> jobs;
+    std::thread writer;
+
+    double encodeTime = 0;
+
+    void loop();
+};
+
+#endif //VISION_CORE_ASYNC_VIDEO_IO_H
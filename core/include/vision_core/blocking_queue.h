@@ -0,0 +1,52 @@
+#ifndef VISION_CORE_BLOCKING_QUEUE_H
+#define VISION_CORE_BLOCKING_QUEUE_H
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+/**
+ * Minimal thread-safe FIFO used to hand buffers between pipeline stages.
+ * Once closed, pop() drains the remaining items and then returns false.
+ */
+template <typename T>
+class BlockingQueue {
+    std::deque<T> items;
+    std::mutex mutex;
+    std::condition_variable not_empty;
+    bool closed = false;
+
+public:
+    void push(T item) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            items.push_back(std::move(item));
+        }
+        not_empty.notify_one();
+    }
+
+    /**
+     * Blocks until an item is available or the queue is closed.
+     * @return false if the queue has been closed and is empty
+     */
+    bool pop(T &item) {
+        std::unique_lock<std::mutex> lock(mutex);
+        not_empty.wait(lock, [this] { return closed || !items.empty(); });
+        if (items.empty())
+            return false;
+
+        item = std::move(items.front());
+        items.pop_front();
+        return true;
+    }
+
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            closed = true;
+        }
+        not_empty.notify_all();
+    }
+};
+
+#endif //VISION_CORE_BLOCKING_QUEUE_H
@@ -0,0 +1,87 @@
+#ifndef VISION_CORE_CALIBRATION_COVERAGE_H
+#define VISION_CORE_CALIBRATION_COVERAGE_H
+
+#include <vector>
+#include <opencv2/core.hpp>
+
+struct CalibrationCoverageOptions {
+    // cells of the image the board corners are counted in
+    cv::Size grid = cv::Size(8, 6);
+    // views kept at most
+    int budget = 40;
+    // cells no kept view reaches that a view must reach to be kept, unless it shows the board in a new pose
+    int minNewCells = 3;
+};
+
+/**
+ * Picks the views of a calibration board worth giving to cv::calibrateCamera out of a stream (e.g. a video)
+ * where most views are near-duplicates of the previous ones: a view is kept only if its corners reach parts
+ * of the image no kept view reached, or if the board is seen in a new pose, until the budget is reached.
+ * Poses are told apart without calibration, from the corners alone: apparent size of the board
+ * (distance) and foreshortening of its opposite sides (tilt around each axis).
+ */
+class CalibrationFrameSelector {
+public:
+    /**
+     * @param imageSize size of the frames
+     * @param boardSize inner corners per row and per column, as given to cv::findChessboardCorners
+     */
+    CalibrationFrameSelector(cv::Size imageSize, cv::Size boardSize,
+                             const CalibrationCoverageOptions &options = CalibrationCoverageOptions());
+
+    /**
+     * @param corners of a view, in the order of cv::findChessboardCorners
+     * @return index of the pose of the board among poseBins()
+     */
+    int poseBin(const std::vector<cv::Point2f> &corners) const;
+
+    static int poseBins();
+
+    /**
+     * Cells reached by corners that no kept view reaches.
+     */
+    int newCells(const std::vector<cv::Point2f> &corners) const;
+
+    /**
+     * Whether the view would be kept: budget not reached and new cells or a new pose.
+     * Cheap enough to be called on every frame, on corners found at low resolution.
+     */
+    bool wouldAccept(const std::vector<cv::Point2f> &corners) const;
+
+    /**
+     * Records a kept view (normally after wouldAccept, with the refined corners).
+     */
+    void add(const std::vector<cv::Point2f> &corners);
+
+    int accepted() const;
+
+    bool full() const;
+
+    /**
+     * Fraction of the cells reached by the kept views.
+     */
+    double spatialCoverage() const;
+
+    /**
+     * Number of poses of the kept views.
+     */
+    int posesCovered() const;
+
+    /**
+     * Shades the cells reached by the kept views on frame (BGR), which can be a resized frame, e.g. a preview.
+     */
+    void draw(cv::Mat &frame) const;
+
+private:
+    cv::Size imageSize;
+    cv::Size boardSize;
+    CalibrationCoverageOptions options;
+    // kept views reaching each cell, CV_32S grid
+    cv::Mat cells;
+    std::vector<bool> poses;
+    int views = 0;
+
+    cv::Point cellOf(const cv::Point2f &p) const;
+};
+
+#endif //VISION_CORE_CALIBRATION_COVERAGE_H
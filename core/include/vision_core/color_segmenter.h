@@ -0,0 +1,65 @@
+#ifndef VISION_CORE_COLOR_SEGMENTER_H
+#define VISION_CORE_COLOR_SEGMENTER_H
+
+#include <opencv2/core.hpp>
+
+/**
+ * Segmentation of the pixels close to a reference colour, as in Lab1, over a whole image or a ROI.
+ * The test of each channel is a 256-entry table (pixel accepted if the three tables accept its values),
+ * computed once when the reference changes. When every table accepts a single interval of values, which
+ * is the case of the distance to a reference in BGR, the mask is computed by the vectorized colorRangeMask,
+ * otherwise by one multithreaded pass of table lookups.
+ * The mask and the HSV conversion buffer are kept between calls, segmenting frames of the same size allocates nothing.
+ */
+class ColorSegmenter {
+public:
+    enum ColorSpace {
+        SEGMENT_BGR,
+        // 8-bit OpenCV HSV, hue in [0, 180) with the distance between hues taken around the circle
+        SEGMENT_HSV
+    };
+
+    /**
+     * Accepts every pixel until a reference or tables are set.
+     */
+    ColorSegmenter();
+
+    /**
+     * Accepts the pixels with |channel - reference| < thresholds for each channel.
+     */
+    void setReference(cv::Vec3b reference, cv::Vec3i thresholds, ColorSpace space = SEGMENT_BGR);
+
+    /**
+     * Arbitrary per-channel tests: channel c of a pixel passes if luts[c] is not zero at its value.
+     * @param luts three CV_8UC1 tables of 256 elements
+     */
+    void setLuts(const cv::Mat luts[3], ColorSpace space = SEGMENT_BGR);
+
+    /**
+     * @param image CV_8UC3 BGR
+     * @param roi part of the image to segment, the whole image if not given. Clipped to the image.
+     * @return mask of the size of the (clipped) roi, 255 on the accepted pixels, empty if roi is outside of the image.
+     * Valid until the next call, it is overwritten in place.
+     */
+    const cv::Mat &segment(const cv::Mat &image, cv::Rect roi = cv::Rect());
+
+    /**
+     * Sets the accepted pixels of image (or of roi) to color.
+     * @return number of pixels changed
+     */
+    int recolor(cv::Mat &image, const cv::Scalar &color, cv::Rect roi = cv::Rect());
+
+private:
+    ColorSpace space;
+    uchar luts[3][256];
+    // all the tables are intervals: [lower, upper] on each channel
+    bool isRange;
+    cv::Vec3b lower, upper;
+
+    cv::Mat mask;
+    cv::Mat converted;
+
+    void updateRange();
+};
+
+#endif //VISION_CORE_COLOR_SEGMENTER_H
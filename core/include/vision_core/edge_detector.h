@@ -0,0 +1,64 @@
+#ifndef VISION_CORE_EDGE_DETECTOR_H
+#define VISION_CORE_EDGE_DETECTOR_H
+
+#include <vector>
+#include <opencv2/core.hpp>
+
+/**
+ * Canny edge detector (L1 gradient, 3x3 Sobel) which owns all its intermediate buffers,
+ * so that repeated calls on images of the same size don't allocate.
+ * The BGR to gray conversion is fused into the Sobel pass: the image is split in horizontal bands,
+ * each band converts its rows (plus one halo row above and below) into a small ring buffer
+ * and computes gradients, magnitude and direction from it. Non-maximum suppression runs on the
+ * same bands, hysteresis is done last on the whole image.
+ */
+class EdgeDetector {
+public:
+    /**
+     * @param bands number of horizontal bands processed in parallel, 0 to use one per thread
+     */
+    explicit EdgeDetector(int bands = 0);
+
+    /**
+     * Same semantic as cv::Canny(gray(src), edges, low_threshold, high_threshold).
+     * @param src 8-bit BGR or gray image
+     * @param edges output edge map (CV_8U, 0 or 255), reused if it already has the right size
+     */
+    void detect(const cv::Mat &src, cv::Mat &edges, double low_threshold, double high_threshold);
+
+    /**
+     * @return gray version of the last image passed to detect()
+     */
+    const cv::Mat& gray() const;
+
+    /**
+     * @return x and y Sobel derivatives (CV_16S) of the last image passed to detect()
+     */
+    const cv::Mat& gradientX() const;
+    const cv::Mat& gradientY() const;
+
+private:
+    struct Band {
+        int startRow;
+        int endRow;
+        cv::Mat grayRows;       // ring of 3 gray rows with one pixel of replicated border on each side
+        std::vector<int> strong; // strong edge pixels found in the band, seeds for the hysteresis
+    };
+
+    int requestedBands;
+    std::vector<Band> bands;
+
+    cv::Mat grayImg;
+    cv::Mat dx, dy;
+    cv::Mat magnitude; // CV_32S with a zero border of one pixel, so suppression needs no bound checks
+    cv::Mat direction; // quantized gradient direction, see gradientBand()
+    cv::Mat edgeMap;   // 0 non edge, 1 weak edge, 2 edge
+    std::vector<int> stack;
+
+    void allocate(const cv::Mat &src);
+    void gradientBand(const cv::Mat &src, Band &band);
+    void suppressBand(Band &band, int low, int high);
+    void hysteresis();
+};
+
+#endif //VISION_CORE_EDGE_DETECTOR_H
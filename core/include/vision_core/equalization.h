@@ -0,0 +1,57 @@
+#ifndef VISION_CORE_EQUALIZATION_H
+#define VISION_CORE_EQUALIZATION_H
+
+#include <vector>
+#include <opencv2/core.hpp>
+
+enum EqualizeChannels {
+    EQUALIZE_H = 1,
+    EQUALIZE_S = 2,
+    EQUALIZE_V = 4
+};
+
+/**
+ * Histogram equalization of some channels of a BGR image in the HSV color space.
+ * The default (saturation and value) is the one used by Lab5 on the panoramic image.
+ * @param channels combination of EqualizeChannels
+ */
+void equalizeHSV(const cv::Mat &src, cv::Mat &dst, int channels = EQUALIZE_S | EQUALIZE_V);
+
+/**
+ * Histogram equalization of each channel of a BGR image.
+ */
+void equalizeBGR(const cv::Mat &src, cv::Mat &dst);
+
+/**
+ * equalizeHSV of an image given in parts, e.g. the tiles of an image too large for memory: the histograms
+ * of every part are accumulated first, then each part is remapped with the tables of the whole image,
+ * giving exactly the result of equalizeHSV on the whole image.
+ */
+class HSVEqualizer {
+public:
+    /**
+     * @param channels combination of EqualizeChannels
+     */
+    explicit HSVEqualizer(int channels = EQUALIZE_S | EQUALIZE_V);
+
+    /**
+     * Adds the pixels of part (BGR) to the histograms.
+     */
+    void accumulate(const cv::Mat &part);
+
+    /**
+     * Equalizes part with the histograms accumulated so far, src and dst can be the same.
+     */
+    void apply(const cv::Mat &src, cv::Mat &dst);
+
+private:
+    int channels;
+    // 256 bins of H, S and V
+    cv::Mat histograms[3];
+    cv::Mat luts[3];
+    bool lutsReady = false;
+    cv::Mat hsv;
+    std::vector<cv::Mat> split;
+};
+
+#endif //VISION_CORE_EQUALIZATION_H
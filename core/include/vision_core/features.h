@@ -0,0 +1,14 @@
+#ifndef VISION_CORE_FEATURES_H
+#define VISION_CORE_FEATURES_H
+
+#include <opencv2/core.hpp>
+#include <opencv2/features2d.hpp>
+
+/**
+ * SIFT detector used by the panoramic image and by the tracker.
+ * SIFT moved from xfeatures2d (contrib) to features2d in OpenCV 4.4, the right one is picked at build time.
+ * A detector must not be used by two threads at the same time: create one per thread.
+ */
+cv::Ptr<cv::Feature2D> createSiftDetector();
+
+#endif //VISION_CORE_FEATURES_H
@@ -0,0 +1,70 @@
+#ifndef VISION_CORE_FILTERS_H
+#define VISION_CORE_FILTERS_H
+
+#include <opencv2/core.hpp>
+
+/**
+ * Generic filter holding the input image, the output image and the window size (the Lab3 design).
+ * The result buffer is kept between calls of doFilter(), so filtering the same input again
+ * with other parameters (e.g. from a trackbar) doesn't allocate.
+ */
+class Filter {
+public:
+    /**
+     * @param input_img image to be filtered
+     * @param filter_size size of the square window, made odd if it isn't
+     */
+    Filter(const cv::Mat &input_img, int filter_size);
+    virtual ~Filter() = default;
+
+    /**
+     * Performs the filtering, the base filter just copies the input.
+     */
+    virtual void doFilter();
+
+    const cv::Mat& getResult() const { return result_image; }
+
+    void setInput(const cv::Mat &input_img) { input_image = input_img; }
+
+    void setSize(int size);
+    int getSize() const { return filter_size; }
+
+protected:
+    cv::Mat input_image;
+    cv::Mat result_image;
+    int filter_size;
+};
+
+class GaussianFilter : public Filter {
+public:
+    GaussianFilter(const cv::Mat &input_img, int filter_size, double sigma);
+    void doFilter() override;
+
+    void setSigma(double s) { sigma = s; }
+
+private:
+    double sigma;
+};
+
+class MedianFilter : public Filter {
+public:
+    MedianFilter(const cv::Mat &input_img, int filter_size);
+    void doFilter() override;
+};
+
+/**
+ * Bilateral filter whose window covers +-3 sigma_space.
+ */
+class BilateralFilter : public Filter {
+public:
+    BilateralFilter(const cv::Mat &input_img, double sigma_range, double sigma_space);
+    void doFilter() override;
+
+    void setSigmas(double sigma_range, double sigma_space);
+
+private:
+    double sigmaRange;
+    double sigmaSpace;
+};
+
+#endif //VISION_CORE_FILTERS_H
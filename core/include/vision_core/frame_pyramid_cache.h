@@ -0,0 +1,66 @@
+#ifndef VISION_CORE_FRAME_PYRAMID_CACHE_H
+#define VISION_CORE_FRAME_PYRAMID_CACHE_H
+
+#include <vector>
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+#include <opencv2/video/tracking.hpp>
+
+/**
+ * Keeps the optical flow pyramids of the last two frames of a video.
+ * Each frame is converted to gray and its pyramid is built exactly once: when the next frame is pushed,
+ * the current pyramid becomes the previous one by swapping the buffers, without copies.
+ * The buffers of the dropped pyramid are reused for the new frame.
+ */
+class FramePyramidCache {
+    cv::Size win_size;
+    int max_level;
+    int frames = 0;
+
+    cv::Mat gray;
+    std::vector<cv::Mat> prev_pyr;
+    std::vector<cv::Mat> curr_pyr;
+
+public:
+    /**
+     * @param win_size LK window size, the pyramid borders depend on it
+     * @param max_level LK max pyramid level (0 = no pyramid)
+     */
+    FramePyramidCache(cv::Size win_size, int max_level) : win_size(win_size), max_level(max_level) {}
+
+    /**
+     * Builds the pyramid of frame, the pyramid of the previously pushed frame becomes previous().
+     * frame is not referenced after the call, so it can be modified (e.g. drawn on) afterwards.
+     */
+    void push(const cv::Mat &frame) {
+        std::swap(prev_pyr, curr_pyr);
+
+        if (frame.channels() == 1)
+            frame.copyTo(gray);
+        else
+            cv::cvtColor(frame, gray, cv::COLOR_BGR2GRAY);
+
+        // force the copy of level 0: gray is overwritten by the next push while this pyramid is still in use
+        cv::buildOpticalFlowPyramid(gray, curr_pyr, win_size, max_level, true,
+                                    cv::BORDER_REFLECT_101, cv::BORDER_CONSTANT, false);
+        frames++;
+    }
+
+    bool hasPrevious() const {
+        return frames > 1;
+    }
+
+    const std::vector<cv::Mat>& previous() const {
+        return prev_pyr;
+    }
+
+    const std::vector<cv::Mat>& current() const {
+        return curr_pyr;
+    }
+
+    const cv::Mat& currentGray() const {
+        return gray;
+    }
+};
+
+#endif //VISION_CORE_FRAME_PYRAMID_CACHE_H
@@ -0,0 +1,134 @@
+#ifndef VISION_CORE_IMAGE_IO_H
+#define VISION_CORE_IMAGE_IO_H
+
+#include <condition_variable>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <opencv2/core.hpp>
+#include <opencv2/imgcodecs.hpp>
+
+struct ImageLoadOptions {
+    // cv::imread flags: IMREAD_GRAYSCALE or IMREAD_REDUCED_COLOR_2/4/8 (JPEG decoded directly at 1/2, 1/4, 1/8)
+    // decode less when the stage doesn't need full resolution colour
+    int flags = cv::IMREAD_COLOR;
+    // decoding threads, 0 for cv::getNumThreads()
+    int threads = 0;
+    // images decoded ahead of the consumer at most, bounding the memory of a streamed folder, 0 for 2 * threads
+    int prefetch = 0;
+    // applied to each decoded image on the decoding thread (e.g. a projection or a blur), must be thread safe.
+    // If it throws, the image is skipped like a file that can't be decoded
+    std::function<void(cv::Mat &)> transform;
+};
+
+/**
+ * @param pattern folder or cv::glob pattern (e.g. "folder/*.png")
+ * @return paths matching pattern, sorted
+ */
+std::vector<std::string> listImages(const std::string &pattern);
+
+/**
+ * Decodes a list of images on a pool of threads while the caller consumes them, always in path order,
+ * whatever the order the decodes finish in. At most prefetch images are decoded ahead of the caller,
+ * so a folder of any size can be streamed in bounded memory. Files which can't be decoded are skipped.
+ *
+ *     ImageFolderLoader loader("folder/*.jpg");
+ *     for (const auto &image : loader)
+ *         process(image.path, image.image);
+ */
+class ImageFolderLoader {
+public:
+    struct Image {
+        std::string path;
+        cv::Mat image;
+    };
+
+    class iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = Image;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Image *;
+        using reference = const Image &;
+
+        explicit iterator(ImageFolderLoader *loader = nullptr);
+
+        reference operator*() const { return current; }
+        pointer operator->() const { return &current; }
+        iterator &operator++();
+        bool operator==(const iterator &other) const { return loader == other.loader; }
+        bool operator!=(const iterator &other) const { return loader != other.loader; }
+
+    private:
+        ImageFolderLoader *loader;
+        Image current;
+    };
+
+    /**
+     * @param pattern see listImages
+     */
+    explicit ImageFolderLoader(const std::string &pattern, const ImageLoadOptions &options = ImageLoadOptions());
+
+    explicit ImageFolderLoader(std::vector<std::string> paths, const ImageLoadOptions &options = ImageLoadOptions());
+
+    /**
+     * Stops the decoding threads, images not consumed yet are dropped.
+     */
+    ~ImageFolderLoader();
+
+    ImageFolderLoader(const ImageFolderLoader &) = delete;
+    ImageFolderLoader &operator=(const ImageFolderLoader &) = delete;
+
+    /**
+     * Number of files to decode, including those which will fail.
+     */
+    size_t size() const;
+
+    /**
+     * Blocks until the next image in path order is decoded.
+     * @return false once every image has been returned
+     */
+    bool next(cv::Mat &image, std::string *path = nullptr);
+
+    /**
+     * Streams the remaining images, see next. The loader can be iterated once.
+     */
+    iterator begin();
+
+    iterator end();
+
+private:
+    std::vector<std::string> paths;
+    ImageLoadOptions options;
+    std::vector<std::thread> workers;
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    // next path to decode, next path to return to the caller
+    size_t claimed = 0;
+    size_t consumed = 0;
+    // decoded and not consumed yet, by path index (empty when the decode failed)
+    std::map<size_t, cv::Mat> decoded;
+    bool stopping = false;
+
+    void start();
+    void work();
+};
+
+/**
+ * Reads the images matching pattern in path order, files which can't be decoded are skipped.
+ * Decoding is spread over options.threads threads, see ImageFolderLoader.
+ * @param paths if not null, receives the path of each loaded image
+ * @return number of images loaded
+ */
+int loadImages(const std::string &pattern, std::vector<cv::Mat> &images, std::vector<std::string> *paths,
+               const ImageLoadOptions &options);
+
+int loadImages(const std::string &pattern, std::vector<cv::Mat> &images, std::vector<std::string> *paths = nullptr,
+               int flags = cv::IMREAD_COLOR);
+
+#endif //VISION_CORE_IMAGE_IO_H
@@ -0,0 +1,114 @@
+#ifndef VISION_CORE_OBJECT_MODEL_REGISTRY_H
+#define VISION_CORE_OBJECT_MODEL_REGISTRY_H
+
+#include <string>
+#include <vector>
+#include <opencv2/core.hpp>
+#include <opencv2/features2d.hpp>
+
+/**
+ * Features of an object to track, extracted once.
+ */
+struct ObjectModel {
+    std::string name;
+    // size of the object image, used to build the outline of the object
+    cv::Size size;
+    std::vector<cv::KeyPoint> keypoints;
+    cv::Mat descriptors;
+    // matcher already holding the object descriptors as train set
+    cv::Ptr<cv::DescriptorMatcher> matcher;
+};
+
+/**
+ * Registry of the objects to track.
+ * Keypoints and descriptors of each object are extracted once with a single detectAndCompute pass
+ * of a SIFT detector shared by the whole registry, and each object keeps its own trained matcher.
+ * A combined FLANN index over the descriptors of all the objects allows to match a frame against every
+ * object with a single query per frame keypoint, see matchAll().
+ * The registry can be saved to and loaded from disk (any cv::FileStorage format, e.g. .yml.gz)
+ * so that features don't need to be extracted again when tracking on another video.
+ */
+class ObjectModelRegistry {
+public:
+    // ratio used by the Lowe's test to discard ambiguous matches
+    float matchRatio = 0.8f;
+
+    ObjectModelRegistry();
+
+    /**
+     * Extracts and stores the features of image.
+     * @return id of the new object
+     */
+    int add(const std::string &name, const cv::Mat &image);
+
+    /**
+     * Adds the images matching pattern (see loadImages()), blurred with a gaussian kernel before the extraction.
+     * @return number of objects added
+     */
+    int addImages(const std::string &pattern, cv::Size blur_size, double blur_sigma);
+
+    /**
+     * Loads the objects from model_path if it can be read, otherwise adds the images matching pattern
+     * (see addImages()) and saves the result to model_path. The combined index is built in both cases.
+     * @param model_path may be empty, in which case the images are always used
+     */
+    void loadOrAddImages(const std::string &model_path, const std::string &pattern, cv::Size blur_size, double blur_sigma);
+
+    /**
+     * Extracts keypoints and descriptors of img (e.g. a video frame) with the shared detector.
+     */
+    void extract(const cv::Mat &img, std::vector<cv::KeyPoint> &keypoints, cv::Mat &descriptors);
+
+    /**
+     * Matches the descriptors of a frame against the descriptors of object id.
+     * Resulting matches have queryIdx referring to frame_descriptors and trainIdx referring to the object keypoints.
+     */
+    void match(int id, const cv::Mat &frame_descriptors, std::vector<cv::DMatch> &matches) const;
+
+    /**
+     * Builds the combined index used by matchAll(), must be called after the objects have been added or loaded.
+     */
+    void buildIndex();
+
+    /**
+     * Matches the descriptors of a frame against all the objects at once: each frame descriptor is
+     * assigned to its best object and object keypoint through one query of the combined index.
+     * @param matches will hold the matches of each object, with queryIdx referring to frame_descriptors
+     * and trainIdx referring to the object keypoints
+     */
+    void matchAll(const cv::Mat &frame_descriptors, std::vector<std::vector<cv::DMatch>> &matches) const;
+
+    /**
+     * Finds object id in a frame through RANSAC over the given matches (from match() or matchAll()).
+     * Safe to call concurrently, as long as no object is being added.
+     * @param outline will hold the 4 corners of the object in the frame (top-left, top-right, bottom-left, bottom-right)
+     * @param inliers will hold the frame keypoints consistent with the homography found
+     * @return false if the object is not found
+     */
+    bool locate(int id, const std::vector<cv::KeyPoint> &frame_keypoints, const std::vector<cv::DMatch> &matches,
+                double ransac_reproject_error, std::vector<cv::Point2f> &outline, std::vector<cv::Point2f> &inliers) const;
+
+    bool save(const std::string &path) const;
+
+    /**
+     * Replaces the content of the registry with the objects stored at path.
+     * @return false if the file can't be read
+     */
+    bool load(const std::string &path);
+
+    int size() const;
+
+    const ObjectModel& operator[](int id) const;
+
+private:
+    cv::Ptr<cv::Feature2D> detector;
+    std::vector<ObjectModel> models;
+
+    cv::Ptr<cv::DescriptorMatcher> combinedMatcher;
+    // object id of each image of the combined matcher, objects without descriptors are not added to it
+    std::vector<int> indexObjects;
+
+    static void train(ObjectModel &model);
+};
+
+#endif //VISION_CORE_OBJECT_MODEL_REGISTRY_H
@@ -0,0 +1,200 @@
+#ifndef VISION_CORE_PANORAMIC_IMAGE_H
+#define VISION_CORE_PANORAMIC_IMAGE_H
+
+#include <string>
+#include <utility>
+#include <vector>
+#include <opencv2/core.hpp>
+#include <opencv2/features2d.hpp>
+#include "vision_core/features.h"
+#include "vision_core/phase_correlation.h"
+#include "vision_core/tiled_canvas.h"
+#include "vision_core/translation_estimator.h"
+
+/**
+ * Panoramic image of a horizontal sweep of pictures (Lab5): features and matches of consecutive pictures,
+ * optionally restricted to their overlap and computed at low resolution, translation of each pair, then
+ * composition into a Mat or a TiledCanvas.
+ *
+ *     PanoramicImage panoramic(folder, fov);
+ *     panoramic.findKeypoints().findMatches().refineAndComputeTranslations(match_filter_ratio);
+ *     cv::Mat result = panoramic.composePanoramicImage();
+ */
+class PanoramicImage {
+    cv::Ptr<cv::Feature2D> extractor = createSiftDetector();
+    // Enable crossCheck for consistency
+    cv::BFMatcher matcher = cv::BFMatcher(cv::NORM_L2, true);
+    TranslationEstimator translation_estimator;
+
+    // Columns of image i (first) and of image i+1 (second) which can overlap, for each pair of consecutive images.
+    // Empty: the whole images
+    std::vector<std::pair<std::vector<cv::Range>, std::vector<cv::Range>>> overlap_columns;
+    // Keypoints kept per image, the strongest ones, 0 keeps all
+    int max_keypoints = 0;
+
+    // Features and translations are computed on the images scaled by align_scale, composition uses the full images
+    double align_scale = 1;
+    std::vector<cv::Mat> small_images;
+    // Half size of the full resolution search refining each translation, 0 to keep the low resolution estimate
+    int refine_window = 0;
+
+    // Pairs whose phase correlation peak reaches min_phase_response skip SIFT, 0 disables the phase correlation
+    double min_phase_response = 0;
+    PhaseCorrelator phase_correlator;
+    std::vector<double> phase_responses;
+
+    const std::vector<cv::Mat>& alignmentImages() const;
+
+    /**
+     * Best horizontal translation of image i+1 with respect to image i within refine_window pixels of dx,
+     * by template matching a central patch of their overlap at full resolution. The patch has a bounded size,
+     * so the cost doesn't depend on the resolution of the images.
+     */
+    float refineTranslation(int i, float dx) const;
+
+    // Columns of a pair of images of width cols which overlap when the second is translated by dx, widened by margin
+    static std::pair<std::vector<cv::Range>, std::vector<cv::Range>> overlapFromTranslation(float dx, int cols, int margin);
+
+    /**
+     * Phase correlation of each pair of consecutive images, on the strips of overlap_columns (every pairing of a
+     * strip of the first image with one of the second, the strongest peak wins) or on the whole images.
+     */
+    void alignByPhaseCorrelation();
+
+    // SIFT features of image downscaled by scale, the strongest max_features, in the coordinates of the copy
+    void smallFeatures(const cv::Mat &image, double scale, int max_features, std::vector<cv::KeyPoint> &kp, cv::Mat &ds);
+
+    // translation between the features of two downscaled copies, in the coordinates of the copies
+    TranslationEstimate smallTranslation(const std::vector<cv::KeyPoint> &kp1, const cv::Mat &ds1,
+                                         const std::vector<cv::KeyPoint> &kp2, const cv::Mat &ds2);
+
+    // Columns image i searches for features: the strips it shares with the previous and next images, merged,
+    // or the whole image without an overlap prior
+    std::vector<cv::Range> searchedColumns(int i) const;
+
+    static bool inColumns(const cv::KeyPoint &kp, const std::vector<cv::Range> &columns);
+
+public:
+    std::vector<cv::Mat> images;
+    std::vector<std::vector<cv::KeyPoint>> keypoints;
+    // descriptors[i] row j describes keypoints[i][j], computed once per image
+    std::vector<cv::Mat> descriptors;
+    std::vector<std::vector<cv::DMatch>> matches;
+    std::vector<int> x_translations;
+    // confidence of each translation (TranslationEstimate::confidence) and whether it passed the estimator checks
+    std::vector<double> translation_confidence;
+    std::vector<bool> reliable_translations;
+    // pairs aligned by phase correlation and their translation, in alignment pixels, filled by findKeypoints
+    std::vector<bool> phase_aligned;
+    std::vector<float> phase_translations;
+
+
+    /**
+     * Loads the pictures of images_folder_path and projects them on a cylinder.
+     * @param FOV field of view of the camera, in degrees
+     */
+    PanoramicImage(std::string images_folder_path, int FOV);
+
+    /**
+     * Images already loaded (and projected), in sweep order.
+     */
+    explicit PanoramicImage(std::vector<cv::Mat> projected_images);
+
+    /**
+     * Computes features, matches and translations on copies of the images scaled by scale, so that their cost
+     * doesn't grow with the resolution of the pictures, the panoramic image is still composed at full resolution.
+     * Must be called before useOverlapPrior or estimateOverlap.
+     * @param refine_window if > 0, each translation is refined at full resolution within +- refine_window pixels
+     */
+    PanoramicImage& alignAtScale(double scale, int refine_window = 0);
+
+    /**
+     * Keeps only the max_keypoints keypoints with the highest response of each image (0: no limit).
+     */
+    PanoramicImage& limitKeypoints(int max_keypoints);
+
+    /**
+     * Feature-free fast path: findKeypoints first aligns each pair of consecutive images by phase correlation
+     * (on the overlap strips if an overlap is known) and only pairs with a weak peak go through SIFT,
+     * images whose both pairs are aligned are not searched for features at all.
+     * @param min_response minimum peak response (PhaseCorrelation::response) of an accepted pair, 0 disables it
+     */
+    PanoramicImage& usePhaseCorrelation(double min_response = 0.1);
+
+    /**
+     * Restricts detection and matching to the strips that consecutive images can share.
+     * The direction of the sweep is found from the first pair of images on downscaled copies, so that each pair
+     * only uses the side of each image facing the other one. If it can't be found a strip on each side is used.
+     * @param overlap fraction of the width shared by consecutive images (e.g. 0.3)
+     * @param margin added to the strips, fraction of the width, for the uncertainty of the prior
+     * @param scale of the copies the direction is found on
+     */
+    PanoramicImage& useOverlapPrior(double overlap, double margin = 0.05, double scale = 0.25);
+
+    /**
+     * Estimates the overlap of each pair of consecutive images from SIFT matches on downscaled copies,
+     * then restricts detection and matching to it as useOverlapPrior. Pairs without enough matches keep
+     * the whole images.
+     * @param scale of the copies
+     * @param margin added to the overlaps, fraction of the width
+     */
+    PanoramicImage& estimateOverlap(double scale = 0.25, double margin = 0.05);
+
+    /**
+     * Extract features for each image.
+     * Result will be available at PanoramicImage.keypoints and PanoramicImage.descriptors,
+     * where keypoints[i] will contains the features found on image i.
+     * With an overlap prior only the strips shared with the previous and next images are searched: each strip is
+     * cropped and searched on its own, since SIFT builds its pyramid on the whole image it is given and would only
+     * use a mask to discard keypoints afterwards.
+    */
+    PanoramicImage& findKeypoints();
+
+    /**
+     * Extract matches for each pair of consecutive images.
+     * Result will be available at PanoramicImage.matches,
+     * where matches[i] will contains the matches from image i to image i+1.
+     * With an overlap prior only the keypoints inside the overlap of the pair are matched.
+    */
+    PanoramicImage& findMatches();
+
+    /**
+     * Compute translations from iamge i to image i+1.
+     * Result will be available at PanoramicImage.x_translations, in full resolution pixels.
+     * Note that outliers will be discarded by the translation estimator, pairs without a reliable translation
+     * are reported and take the median translation of the others. Pairs aligned by phase correlation keep their
+     * translation, with the peak response as confidence.
+     * @param match_filter_ratio Considering the minimum distance between a pair of matches, if the distance
+     * of a match is greater than match_filter_ratio * min_pair_distance then the match is excluded.
+     */
+    PanoramicImage& refineAndComputeTranslations(float match_filter_ratio);
+
+    /**
+     * Width of the panoramic image composed from x_translations.
+     */
+    int panoramicWidth() const;
+
+    /**
+     * @return Composed image
+     */
+    cv::Mat composePanoramicImage();
+
+    /**
+     * Composes the panoramic image into canvas instead of one contiguous Mat, strip by strip and tile by tile,
+     * so that with a directory it never needs to fit in memory.
+     * @param directory backing file location of the canvas, see TiledCanvas::create
+     * @return false if the canvas can't be created
+     */
+    bool composePanoramicImage(TiledCanvas &canvas, const std::string &directory = "");
+
+private:
+    /**
+     * Calls write(strip, position in the panoramic image) for the first image then the new part of each next one.
+     */
+    template <typename Writer>
+    void composeStrips(Writer write) const;
+
+};
+
+
+#endif //VISION_CORE_PANORAMIC_IMAGE_H
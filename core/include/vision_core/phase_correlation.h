@@ -0,0 +1,54 @@
+#ifndef VISION_CORE_PHASE_CORRELATION_H
+#define VISION_CORE_PHASE_CORRELATION_H
+
+#include <map>
+#include <utility>
+#include <opencv2/core.hpp>
+
+struct PhaseCorrelation {
+    // b(x + shift) = a(x), sub-pixel
+    cv::Point2d shift;
+    // share of the correlation energy around the peak, ~1 for identical images, ~0 when there is no common content
+    double response = 0;
+};
+
+/**
+ * Translation between two images from the peak of their windowed phase correlation, without features:
+ * it only needs the images to share some structure, so it also works where detectors find little
+ * (sky, walls), and its cost doesn't depend on the content.
+ * The images are zero padded to twice their width (a quarter more rows), so horizontal shifts up to the
+ * width are not aliased. Windows, padded buffers and spectra are kept per image size and reused by the
+ * following calls of the same size, e.g. the pairs of a sweep. Not thread safe.
+ */
+class PhaseCorrelator {
+public:
+    /**
+     * @param a first image, 8-bit or float, gray or BGR
+     * @param b second image, same type as a; if the sizes differ both are cropped to the common top-left part
+     */
+    PhaseCorrelation correlate(const cv::Mat &a, const cv::Mat &b);
+
+    size_t cachedSizes() const;
+
+    void clear();
+
+private:
+    struct Plan {
+        // Hanning window of the input size
+        cv::Mat window;
+        // padded inputs, their spectra and the normalized cross-power spectrum
+        cv::Mat padded_a, padded_b;
+        cv::Mat spectrum_a, spectrum_b;
+        cv::Mat cross;
+        cv::Mat correlation;
+    };
+
+    std::map<std::pair<int, int>, Plan> plans;
+    cv::Mat gray;
+
+    Plan& plan(cv::Size size);
+
+    void prepare(const cv::Mat &src, const Plan &p, cv::Mat &padded);
+};
+
+#endif //VISION_CORE_PHASE_CORRELATION_H
@@ -0,0 +1,53 @@
+#ifndef VISION_CORE_PIXEL_KERNELS_H
+#define VISION_CORE_PIXEL_KERNELS_H
+
+#include <vector>
+#include <opencv2/core.hpp>
+
+/**
+ * Per-pixel loops that OpenCV has no direct function for, compiled for several instruction sets
+ * (core/src/kernels) in the same binary. The best one supported by the CPU is chosen at the first call,
+ * the environment variable CVLAB_KERNEL_ISA (scalar, sse4.1, avx2, avx512, neon) forces a lower one.
+ * Every version gives exactly the same result as the scalar one.
+ */
+enum KernelIsa {
+    KERNEL_SCALAR,
+    KERNEL_SSE41,
+    KERNEL_AVX2,
+    KERNEL_AVX512,
+    KERNEL_NEON
+};
+
+const char *kernelIsaName(KernelIsa isa);
+
+/**
+ * Instruction sets compiled in the binary and supported by the CPU, scalar first.
+ */
+std::vector<KernelIsa> supportedKernelIsas();
+
+KernelIsa activeKernelIsa();
+
+/**
+ * Switches all the kernels to the given instruction set (used by the benchmarks and by the equality checks).
+ * @return false, and nothing changes, if the instruction set is not supported
+ */
+bool setKernelIsa(KernelIsa isa);
+
+/**
+ * mask = 255 where lower[c] <= src[c] <= upper[c] for the three channels, 0 elsewhere: the same as cv::inRange
+ * on CV_8UC3, without the conversions of the bounds to double.
+ * @param src CV_8UC3, can be a ROI
+ * @param mask CV_8UC1 of the size of src, reallocated if needed
+ */
+void colorRangeMask(const cv::Mat &src, cv::Mat &mask, cv::Vec3b lower, cv::Vec3b upper);
+
+/**
+ * dst(y, x) = the pixel starting at byte offsets(y, x) of src: a nearest-neighbour remap with the
+ * source coordinates precomputed as byte offsets (row * step + col * 3).
+ * @param src continuous CV_8UC3
+ * @param offsets CV_32SC1, every offset must point to a whole pixel of src
+ * @param dst CV_8UC3 of the size of offsets, must not share data with src
+ */
+void gatherPixels(const cv::Mat &src, const cv::Mat &offsets, cv::Mat &dst);
+
+#endif //VISION_CORE_PIXEL_KERNELS_H
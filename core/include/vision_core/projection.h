@@ -0,0 +1,35 @@
+#ifndef VISION_CORE_PROJECTION_H
+#define VISION_CORE_PROJECTION_H
+
+#include <opencv2/core.hpp>
+
+/**
+ * Cylindrical projection of the Lab5 pictures, same result as the per-pixel loop of PanoramicUtils.
+ * The source coordinates of each pixel only depend on the image size and on the angle, so they are
+ * computed once into a map and every following image of the same size is a single gather of pixels
+ * (gatherPixels, cv::remap for other types than continuous CV_8UC3).
+ * Pixels falling outside of the projection keep their original value.
+ */
+class CylindricalProjector {
+public:
+    /**
+     * @param angle half field of view of the camera, in degrees
+     */
+    void project(const cv::Mat &src, cv::Mat &dst, double angle);
+
+private:
+    cv::Size mapSize;
+    double mapAngle = 0;
+    cv::Mat map;
+    // the same map as byte offsets in a continuous CV_8UC3 image
+    cv::Mat offsets;
+
+    void buildMap(cv::Size size, double angle);
+};
+
+/**
+ * Convenience wrapper over a per-thread CylindricalProjector.
+ */
+cv::Mat cylindricalProj(const cv::Mat &image, double angle);
+
+#endif //VISION_CORE_PROJECTION_H
@@ -0,0 +1,71 @@
+#ifndef VISION_CORE_REDETECTION_WORKER_H
+#define VISION_CORE_REDETECTION_WORKER_H
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <opencv2/core.hpp>
+#include <opencv2/features2d.hpp>
+#include "vision_core/object_model_registry.h"
+
+/**
+ * Object found again by the re-detection worker.
+ * Outline and points refer to the frame on which the detection ran, stored in gray.
+ */
+struct Redetection {
+    int object;
+    int frameIndex;
+    cv::Mat gray;
+    std::vector<cv::Point2f> outline;
+    std::vector<cv::Point2f> points;
+};
+
+/**
+ * Runs the SIFT + matching + RANSAC detection of initTracking on a background thread,
+ * for the objects whose tracking has been lost or is degrading.
+ * The frame loop never waits for it: request() is ignored while a detection is running
+ * and collect() only returns the detections already completed.
+ */
+class RedetectionWorker {
+public:
+    /**
+     * @param models objects to detect, with the combined index built.
+     * Must outlive the worker and must not change while it runs
+     */
+    RedetectionWorker(const ObjectModelRegistry &models, double ransac_reproject_error);
+    ~RedetectionWorker();
+
+    /**
+     * Starts the detection of objects on a copy of frame.
+     * @return false if the worker is still busy with a previous request, in which case nothing is done
+     */
+    bool request(const cv::Mat &frame, int frame_index, const std::vector<int> &objects);
+
+    /**
+     * Moves the detections completed since the last call into results, without blocking.
+     * @return true if the worker is idle, i.e. a new request would be accepted
+     */
+    bool collect(std::vector<Redetection> &results);
+
+private:
+    const ObjectModelRegistry &models;
+    double ransacReprojectError;
+    // Feature2D instances are not meant to be shared between threads, the worker has its own
+    cv::Ptr<cv::Feature2D> detector;
+
+    std::thread worker;
+    std::mutex state_mutex;
+    std::condition_variable has_work;
+    bool busy = false;
+    bool stop = false;
+
+    cv::Mat frame;
+    int frameIndex = 0;
+    std::vector<int> objects;
+    std::vector<Redetection> completed;
+
+    void loop();
+};
+
+#endif //VISION_CORE_REDETECTION_WORKER_H
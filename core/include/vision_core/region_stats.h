@@ -0,0 +1,56 @@
+#ifndef VISION_CORE_REGION_STATS_H
+#define VISION_CORE_REGION_STATS_H
+
+#include <opencv2/core.hpp>
+
+/**
+ * Mean and variance of any rectangle of an image in constant time.
+ * The integral images of the channels and of their squares are built once per image (one pass),
+ * every query then reads four corners of each, whatever the size of the rectangle.
+ * Rectangles are clipped to the image, the statistics of an empty rectangle are zero.
+ */
+class RegionStats {
+public:
+    RegionStats() = default;
+
+    explicit RegionStats(const cv::Mat &image);
+
+    /**
+     * @param image up to 4 channels, any depth
+     */
+    void build(const cv::Mat &image);
+
+    bool empty() const;
+
+    /**
+     * rect intersected with the image.
+     */
+    cv::Rect clip(const cv::Rect &rect) const;
+
+    /**
+     * Per-channel mean of the pixels of rect, the same as cv::mean on the clipped rect.
+     */
+    cv::Scalar mean(const cv::Rect &rect) const;
+
+    /**
+     * Per-channel (population) variance of the pixels of rect, the square of the deviation of cv::meanStdDev.
+     */
+    cv::Scalar variance(const cv::Rect &rect) const;
+
+    /**
+     * Mean and variance at once, reading the integral images once.
+     * @return number of pixels of the clipped rect
+     */
+    int query(const cv::Rect &rect, cv::Scalar &mean, cv::Scalar &variance) const;
+
+private:
+    int channels = 0;
+    cv::Size size;
+    // (rows + 1) x (cols + 1), CV_64F with the channels of the image
+    cv::Mat sum;
+    cv::Mat sqsum;
+
+    cv::Scalar rectSum(const cv::Mat &integral, const cv::Rect &rect) const;
+};
+
+#endif //VISION_CORE_REGION_STATS_H
@@ -0,0 +1,21 @@
+#ifndef VISION_CORE_STREAM_DETECTOR_PARAMS_H
+#define VISION_CORE_STREAM_DETECTOR_PARAMS_H
+
+/**
+ * Parameters of the Canny + HoughLines + HoughCircles chain of the Lab4 lane and sign detector.
+ * Defaults are the ones tuned on the Lab4 still image.
+ */
+struct StreamDetectorParams {
+    int minThreshold = 283;
+    int ratio = 3;
+    int rhoAccumulator = 1;
+    int thetaAccumulator = 3; // degrees
+    int threshold = 120;
+    int circleAccThreshold = 17;
+    int circleMaxRadius = 30;
+    int maxLines = 2;
+    // half-width (degrees) of the theta window searched around each line of the previous frame
+    double seedThetaWindow = 9;
+};
+
+#endif //VISION_CORE_STREAM_DETECTOR_PARAMS_H
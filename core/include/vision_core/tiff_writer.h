@@ -0,0 +1,60 @@
+#ifndef VISION_CORE_TIFF_WRITER_H
+#define VISION_CORE_TIFF_WRITER_H
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <opencv2/core.hpp>
+
+/**
+ * Streams an uncompressed tiled TIFF one tile at a time, so that images larger than memory can be saved:
+ * only one tile is held at a time, the tile index is written at the end.
+ * Files that can exceed 4 GB are written as BigTIFF, the others as classic TIFF, which more readers open.
+ */
+class TiledTiffWriter {
+public:
+    TiledTiffWriter() = default;
+
+    ~TiledTiffWriter();
+
+    TiledTiffWriter(const TiledTiffWriter &) = delete;
+    TiledTiffWriter &operator=(const TiledTiffWriter &) = delete;
+
+    /**
+     * @param type CV_8UC1 or CV_8UC3 (BGR, stored as RGB)
+     * @param tileSize multiple of 16, as required by TIFF
+     * @return false if the file can't be created
+     */
+    bool open(const std::string &path, cv::Size size, int type, int tileSize = 256);
+
+    bool isOpen() const;
+
+    /**
+     * Tiles can come in any order, each one once. Tiles of the last column and row are the part inside the image
+     * and are padded with zeros.
+     */
+    bool writeTile(int tx, int ty, const cv::Mat &tile);
+
+    /**
+     * Writes the tile index and closes the file. Tiles never written are left empty (zero bytes).
+     * @return false if writing failed
+     */
+    bool close();
+
+private:
+    std::ofstream out;
+    cv::Size size;
+    int type = 0;
+    int tileSize = 256;
+    cv::Size grid;
+    bool bigTiff = false;
+    std::vector<uint64_t> offsets;
+    std::vector<uint64_t> byteCounts;
+    cv::Mat buffer;
+
+    void put(uint64_t value, int bytes);
+    void entry(uint16_t tag, uint16_t fieldType, uint64_t count, uint64_t value);
+};
+
+#endif //VISION_CORE_TIFF_WRITER_H
@@ -0,0 +1,113 @@
+#ifndef VISION_CORE_TILED_CANVAS_H
+#define VISION_CORE_TILED_CANVAS_H
+
+#include <functional>
+#include <string>
+#include <vector>
+#include <opencv2/core.hpp>
+#include "vision_core/equalization.h"
+
+/**
+ * Image stored as square tiles, each one contiguous, for images larger than memory (e.g. panoramas a hundred
+ * thousand pixels wide). With a directory the tiles live in a memory-mapped temporary file there: the system
+ * pages them in and out as they are touched and only the tiles being worked on need to be resident.
+ * Without a directory (or where mapping files is not supported) the tiles are kept in memory.
+ * Every operation goes tile by tile, so it touches a bounded amount of memory at a time.
+ */
+class TiledCanvas {
+public:
+    TiledCanvas() = default;
+
+    /**
+     * See create.
+     */
+    TiledCanvas(cv::Size size, int type, int tileSize = 256, const std::string &directory = "");
+
+    ~TiledCanvas();
+
+    TiledCanvas(const TiledCanvas &) = delete;
+    TiledCanvas &operator=(const TiledCanvas &) = delete;
+
+    /**
+     * Allocates a canvas of zeros, releasing the previous one.
+     * @param directory where the backing file is created (it is deleted with the canvas), empty to keep the tiles in memory
+     * @return false if the backing file can't be created or mapped
+     */
+    bool create(cv::Size size, int type, int tileSize = 256, const std::string &directory = "");
+
+    void release();
+
+    bool empty() const;
+
+    cv::Size size() const;
+
+    int type() const;
+
+    int tileSize() const;
+
+    /**
+     * Number of tiles horizontally and vertically.
+     */
+    cv::Size tiles() const;
+
+    /**
+     * Part of the canvas covered by tile (tx, ty), smaller than tileSize on the right and bottom borders.
+     */
+    cv::Rect tileRect(int tx, int ty) const;
+
+    /**
+     * The pixels of tile (tx, ty), a header on the storage of the canvas: writing to it writes the canvas.
+     */
+    cv::Mat tile(int tx, int ty);
+
+    /**
+     * Copies src into the canvas with its top left corner at offset, clipped to the canvas.
+     */
+    void write(const cv::Mat &src, cv::Point offset);
+
+    /**
+     * Copies the part rect of the canvas (clipped) into dst.
+     */
+    void read(const cv::Rect &rect, cv::Mat &dst) const;
+
+    /**
+     * Calls fn on each tile, row by row, with its rect in the canvas and its pixels (see tile).
+     */
+    void forEachTile(const std::function<void(const cv::Rect &, cv::Mat &)> &fn);
+
+    /**
+     * Read-only forEachTile, for a const canvas.
+     */
+    void forEachTile(const std::function<void(const cv::Rect &, const cv::Mat &)> &fn) const;
+
+    /**
+     * Saves the canvas (CV_8UC1 or CV_8UC3) as a tiled TIFF, BigTIFF beyond 4 GB, one tile at a time.
+     * @return false if the file can't be written
+     */
+    bool writeTiff(const std::string &path) const;
+
+private:
+    cv::Size canvasSize;
+    int canvasType = 0;
+    int side = 256;
+    cv::Size grid;
+    size_t tileBytes = 0;
+
+    uchar *data = nullptr;
+    size_t bytes = 0;
+    // storage without a backing file
+    std::vector<uchar> memory;
+    // mapped backing file, -1 without one
+    int fd = -1;
+
+    // header on the storage of tile (tx, ty), the public accessors decide whether it may be written
+    cv::Mat tileHeader(int tx, int ty) const;
+};
+
+/**
+ * equalizeHSV of a whole canvas, in two passes over its tiles (histograms, then remapping).
+ * @param channels combination of EqualizeChannels
+ */
+void equalizeHSV(TiledCanvas &canvas, int channels = EQUALIZE_S | EQUALIZE_V);
+
+#endif //VISION_CORE_TILED_CANVAS_H
@@ -0,0 +1,173 @@
+#ifndef VISION_CORE_TILED_VIEWER_H
+#define VISION_CORE_TILED_VIEWER_H
+
+#include <cstdint>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <opencv2/core.hpp>
+#include <opencv2/highgui.hpp>
+
+struct TiledViewerOptions {
+    // size of the displayed canvas, the image is fitted in it at the start
+    cv::Size viewport = cv::Size(1280, 720);
+    int tileSize = 256;
+    // if not empty the tiles are written there (PNG) and read back on demand instead of being kept in memory,
+    // defaults to the CVLAB_TILE_CACHE environment variable
+    std::string cacheDirectory;
+    // tiles decoded and kept in memory at the same time with a disk cache
+    int maxCachedTiles = 256;
+
+    TiledViewerOptions();
+};
+
+/**
+ * Pyramid of an image (each level half the size of the previous one) cut in square tiles, either kept in
+ * memory or stored on disk. Only the tiles covering the requested region at the requested level are read.
+ */
+class TilePyramid {
+public:
+    /**
+     * Builds every level of image, in the cache directory of options if it is set.
+     * @param name subdirectory of the cache directory, so that several pyramids can share it
+     */
+    void build(const cv::Mat &image, const TiledViewerOptions &options, const std::string &name);
+
+    /**
+     * Opens the pyramid of an image file. With a cache directory, a pyramid built before from the same file
+     * (same size and modification time) is reused without decoding the image.
+     * @return false if the image can't be read
+     */
+    bool open(const std::string &path, const TiledViewerOptions &options);
+
+    bool empty() const;
+
+    /**
+     * Size of level 0, the full resolution image.
+     */
+    cv::Size size() const;
+
+    int levels() const;
+
+    cv::Size levelSize(int level) const;
+
+    /**
+     * Copies the part rect (in the coordinates of level) of the level into dst.
+     */
+    void read(int level, const cv::Rect &rect, cv::Mat &dst);
+
+private:
+    int tileSize = 256;
+    int type = 0;
+    std::vector<cv::Size> sizes;
+
+    // in memory: the levels themselves
+    std::vector<cv::Mat> memoryLevels;
+
+    // on disk: tile files and the least recently used tiles decoded
+    std::string directory;
+    int maxCachedTiles = 256;
+    std::list<uint64_t> lru;
+    std::unordered_map<uint64_t, std::pair<cv::Mat, std::list<uint64_t>::iterator>> cache;
+
+    const cv::Mat &tile(int level, int tx, int ty);
+    std::string tilePath(int level, int tx, int ty) const;
+    void writeManifest(const std::string &source) const;
+    bool readManifest(const std::string &source);
+};
+
+/**
+ * Window showing an image of any size at any zoom: only the visible part is composed, from the level of
+ * the pyramid closest to the zoom, so that panoramas or full resolution pictures display at the same speed
+ * as a small image and, with a disk cache, without the image being decoded in memory.
+ *
+ * Wheel zooms around the cursor, dragging with the right (or middle) button pans, a double click fits the
+ * image in the window. Keys, handled by waitKey: + - zoom, w a s d pan, f fit, 1 full resolution.
+ * The mouse callback receives the coordinates in the full resolution image.
+ */
+class TiledViewer {
+public:
+    explicit TiledViewer(const std::string &window, const TiledViewerOptions &options = TiledViewerOptions());
+
+    ~TiledViewer();
+
+    TiledViewer(const TiledViewer &) = delete;
+    TiledViewer &operator=(const TiledViewer &) = delete;
+
+    /**
+     * Shows image, rebuilding the pyramid. The view (zoom and position) is kept if the size doesn't change.
+     * Without a disk cache the full resolution level shares the data of image: call show again after changing it.
+     */
+    void show(const cv::Mat &image);
+
+    /**
+     * Shows an image file, see TilePyramid::open.
+     */
+    bool open(const std::string &path);
+
+    /**
+     * Events of the window with x, y in full resolution coordinates. Events outside of the image are not forwarded.
+     */
+    void setMouseCallback(cv::MouseCallback callback, void *userdata = nullptr);
+
+    /**
+     * Full resolution coordinates of a point of the window.
+     */
+    cv::Point2d toImage(const cv::Point &window_point) const;
+
+    /**
+     * Fits the whole image in the window.
+     */
+    void fit();
+
+    /**
+     * Zoom factor (window pixels per image pixel) around a point of the window.
+     */
+    void zoom(double factor, const cv::Point &window_point);
+
+    /**
+     * Moves the view by (dx, dy) window pixels.
+     */
+    void pan(double dx, double dy);
+
+    /**
+     * Like cv::waitKey, but the navigation keys are handled here instead of being returned.
+     */
+    int waitKey(int delay = 0);
+
+    /**
+     * Handles key if it is a navigation key.
+     */
+    bool handleKey(int key);
+
+    const std::string &windowName() const;
+
+private:
+    std::string window;
+    TiledViewerOptions options;
+    TilePyramid pyramid;
+
+    // full resolution coordinates of the top left corner of the window, window pixels per image pixel
+    cv::Point2d origin;
+    double scale = 1;
+
+    cv::Mat canvas;
+    cv::Mat region;
+
+    cv::MouseCallback callback = nullptr;
+    void *userdata = nullptr;
+    bool dragging = false;
+    cv::Point dragStart;
+
+    double fitScale() const;
+    cv::Size canvasSize() const;
+    void fitView();
+    void clampView();
+    void render();
+    void onMouse(int event, int x, int y, int flags);
+
+    static void mouseHandler(int event, int x, int y, int flags, void *viewer);
+};
+
+#endif //VISION_CORE_TILED_VIEWER_H
@@ -0,0 +1,84 @@
+#ifndef VISION_CORE_TRACE_H
+#define VISION_CORE_TRACE_H
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+/**
+ * Lightweight stage timers and counters shared by the labs.
+ *
+ * Tracing is off unless the CVLAB_TRACE environment variable is set (or trace::enable() is called):
+ * its value is the output prefix, at exit <prefix>.json (Chrome trace, open it in chrome://tracing or Perfetto)
+ * and <prefix>.csv (count, mean, p50/p95/p99 and max per stage, the percentiles from a bounded sample) are written.
+ * When tracing is off a TRACE_SCOPE costs a single relaxed atomic load. Defining CVLAB_DISABLE_TRACE
+ * removes the macros completely.
+ *
+ * Timers can be used from any thread: each thread records into its own buffer, merged only at flush.
+ */
+namespace trace {
+
+    bool enabled();
+
+    /**
+     * Starts recording, output files will be written at output_prefix.json and output_prefix.csv.
+     */
+    void enable(const std::string &output_prefix);
+
+    /**
+     * Records a completed stage, times are steady_clock nanoseconds.
+     */
+    void record(const char *name, int64_t start_ns, int64_t end_ns);
+
+    /**
+     * Adds value to the counter name.
+     */
+    void count(const char *name, int64_t value);
+
+    /**
+     * Writes the trace and the summary collected so far. Called automatically at exit when tracing is enabled.
+     */
+    void flush();
+
+    inline int64_t nowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    /**
+     * Records the time spent between its construction and its destruction under name.
+     * name must be a string literal (or anything living until the next flush).
+     */
+    class ScopedTimer {
+        const char *name;
+        int64_t start;
+        bool active;
+
+    public:
+        explicit ScopedTimer(const char *name) : name(name), start(0), active(enabled()) {
+            if (active)
+                start = nowNs();
+        }
+
+        ~ScopedTimer() {
+            if (active)
+                record(name, start, nowNs());
+        }
+
+        ScopedTimer(const ScopedTimer&) = delete;
+        ScopedTimer& operator=(const ScopedTimer&) = delete;
+    };
+}
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+
+#ifdef CVLAB_DISABLE_TRACE
+#define TRACE_SCOPE(name)
+#define TRACE_COUNT(name, value)
+#else
+#define TRACE_SCOPE(name) trace::ScopedTimer TRACE_CONCAT(trace_scope_, __LINE__)(name)
+#define TRACE_COUNT(name, value) do { if (trace::enabled()) trace::count(name, value); } while (0)
+#endif
+
+#endif //VISION_CORE_TRACE_H
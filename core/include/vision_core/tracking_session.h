@@ -0,0 +1,93 @@
+#ifndef VISION_CORE_TRACKING_SESSION_H
+#define VISION_CORE_TRACKING_SESSION_H
+
+#include <string>
+#include <vector>
+#include <opencv2/core.hpp>
+#include <opencv2/features2d.hpp>
+#include "vision_core/object_model_registry.h"
+#include "vision_core/redetection_worker.h"
+
+struct TrackingConfig {
+    float ransac_reproject_error = 3;
+    // LK keypoints whose backward track ends farther than this (pixels) from where they started are discarded
+    float max_fb_error = 1;
+    // RANSAC stops as soon as a model with this confidence is found
+    double ransac_confidence = 0.995;
+    int ransac_max_iters = 2000;
+    cv::Size lk_win_size = cv::Size(17, 17);
+    int lk_max_pyr_lev = 0;
+    // frames between two scheduled re-detections of the same objects
+    int redetect_interval = 30;
+    // objects keeping less than this fraction of their initial keypoints are re-detected
+    float redetect_min_points_ratio = 0.5;
+    // re-detections can be a few frames old, a pyramid is needed to bring them to the current frame
+    int catch_up_pyr_lev = 3;
+    // LK keypoints kept per object, picked uniformly over a budget_grid x budget_grid grid on the object
+    int max_points_per_object = 150;
+    int budget_grid = 6;
+    // objects with less keypoints than this are re-seeded with corners found inside their outline
+    int min_points_per_object = 30;
+    // minimum distance between re-seeded corners and the keypoints already tracked
+    int reseed_min_distance = 7;
+    // frame buffers shared by the decoder, the tracking loop and the encoder
+    int frame_ring_size = 6;
+    // fps of the output video
+    double output_fps = 15;
+    // log tracking events on cout
+    bool verbose = true;
+};
+
+struct SessionStats {
+    int frames = 0;
+    double seconds = 0;
+    double decode_seconds = 0;
+    double encode_seconds = 0;
+    double wait_seconds = 0;
+    // objects not tracked anymore at the end of the video
+    int lost_objects = 0;
+};
+
+/**
+ * Tracks the objects of a registry on a video, writing the annotated video.
+ * All the per-video state lives in the session, the registry is only read: many sessions
+ * can run concurrently (one per thread) on the same registry, and a session can be reused for several videos.
+ * Memory used by a session is bounded by the frame ring and does not grow with the video length.
+ */
+class TrackingSession {
+public:
+    /**
+     * @param models objects to track, with the combined index built. Must outlive the session.
+     */
+    explicit TrackingSession(const ObjectModelRegistry &models, TrackingConfig config = TrackingConfig());
+
+    /**
+     * @param output_path annotated video, written as MJPG
+     * @return false if the video can't be opened
+     */
+    bool run(const std::string &video_path, const std::string &output_path, SessionStats &stats);
+
+private:
+    const ObjectModelRegistry &models;
+    TrackingConfig config;
+    cv::Ptr<cv::Feature2D> detector;
+    std::vector<cv::Scalar> colors;
+
+    std::vector<bool> tracking_failed;
+    std::vector<std::vector<cv::Point2f>> outline_points_obj; // 4 points defining a rectangle for each obj to track
+    std::vector<std::vector<cv::Point2f>> pts_to_track_obj; // keypoints for each obj to track
+    std::vector<int> initial_points; // keypoints found for each obj by the last detection
+
+    void initTracking(const cv::Mat &frame, const cv::Mat &gray);
+    bool updateKeypointsAndOutline(const std::vector<cv::Mat> &prev_pyr, const std::vector<cv::Mat> &curr_pyr, const cv::Mat &curr_gray,
+                                   std::vector<cv::Point2f> &pts_to_track, std::vector<cv::Point2f> &outline_pts, int &discarded) const;
+    void updateAllObjects(const std::vector<cv::Mat> &prev_pyr, const std::vector<cv::Mat> &curr_pyr, const cv::Mat &curr_gray);
+    void reseed(std::vector<cv::Point2f> &pts, const std::vector<cv::Point2f> &outline, const cv::Mat &gray) const;
+    void applyBudget(std::vector<cv::Point2f> &pts, const std::vector<cv::Point2f> &outline) const;
+    bool catchUpRedetection(Redetection &detection, const cv::Mat &curr_gray) const;
+    void mergeRedetections(std::vector<Redetection> &redetections, const cv::Mat &curr_gray);
+    std::vector<int> redetectionCandidates() const;
+    void drawObjects(cv::Mat &frame) const;
+};
+
+#endif //VISION_CORE_TRACKING_SESSION_H
@@ -0,0 +1,63 @@
+#ifndef VISION_CORE_TRANSLATION_ESTIMATOR_H
+#define VISION_CORE_TRANSLATION_ESTIMATOR_H
+
+#include <vector>
+#include <opencv2/core.hpp>
+
+struct TranslationEstimate {
+    // dst = src + translation for the inliers
+    cv::Point2f translation;
+    // 1 for the matches within threshold of translation, in the order of the matches
+    std::vector<uchar> inliers;
+    int inlierCount = 0;
+    // 0 to 1: how much the translation stands out, 1 - (support of the best clearly different translation) / inlierCount.
+    // Low when another translation has almost as much support, e.g. on repetitive texture
+    double confidence = 0;
+    // enough inliers and confidence, otherwise translation must not be used
+    bool valid = false;
+};
+
+/**
+ * Robust estimation of a pure translation between matched points, the model of the Lab5 panoramas,
+ * instead of a homography fitted with RANSAC: each candidate is a single displacement, so there are
+ * few candidates to score and no degenerate samples.
+ * Candidates are either the peaks of a 2D histogram of the displacements (VOTE) or random single
+ * matches (RANSAC_1PT). Each one is scored on all the displacements at once with vectorized OpenCV
+ * operations, the best is refined as the mean of its inliers.
+ */
+class TranslationEstimator {
+public:
+    enum Method {
+        VOTE,
+        RANSAC_1PT
+    };
+
+    struct Params {
+        Method method = VOTE;
+        // max distance (each axis) between the displacement of an inlier and the translation, pixels
+        float threshold = 3;
+        // histogram bin size of VOTE, pixels
+        float binSize = 4;
+        // candidates drawn by RANSAC_1PT (all the matches if fewer)
+        int iterations = 64;
+        int minInliers = 6;
+        double minConfidence = 0.2;
+    };
+
+    TranslationEstimator() = default;
+
+    explicit TranslationEstimator(const Params &params);
+
+    /**
+     * @param src points of the first image
+     * @param dst matched points of the second image, same size as src
+     */
+    TranslationEstimate estimate(const std::vector<cv::Point2f> &src, const std::vector<cv::Point2f> &dst) const;
+
+private:
+    Params params;
+
+    void candidates(const cv::Mat &displacements, std::vector<cv::Point2f> &result) const;
+};
+
+#endif //VISION_CORE_TRANSLATION_ESTIMATOR_H
@@ -0,0 +1,111 @@
+#include "vision_core/async_video_io.h"
+
+using namespace std;
+using namespace cv;
+
+static double secondsSince(int64 start) {
+    return (getTickCount() - start) / getTickFrequency();
+}
+
+AsyncVideoReader::AsyncVideoReader(const string &path, int ring_size) : cap(path), ring(max(ring_size, 3)) {
+    for (auto &frame : ring)
+        free_frames.push(&frame);
+
+    if (cap.isOpened())
+        reader = thread(&AsyncVideoReader::loop, this);
+    else
+        ready_frames.close();
+}
+
+AsyncVideoReader::~AsyncVideoReader() {
+    // unblock the reader if the caller stopped before the end of the stream
+    free_frames.close();
+    if (reader.joinable())
+        reader.join();
+}
+
+bool AsyncVideoReader::isOpened() const {
+    return cap.isOpened();
+}
+
+Mat* AsyncVideoReader::next() {
+    int64 start = getTickCount();
+    Mat *frame;
+    bool available = ready_frames.pop(frame);
+    waitTime += secondsSince(start);
+
+    return available ? frame : nullptr;
+}
+
+void AsyncVideoReader::recycle(Mat *frame) {
+    free_frames.push(frame);
+}
+
+double AsyncVideoReader::decodeSeconds() const {
+    return decodeTime;
+}
+
+double AsyncVideoReader::waitSeconds() const {
+    return waitTime;
+}
+
+void AsyncVideoReader::loop() {
+    Mat *frame;
+    while (free_frames.pop(frame)) {
+        int64 start = getTickCount();
+        // read() decodes into the existing buffer when the frame size doesn't change
+        bool ok = cap.read(*frame) && !frame->empty();
+        decodeTime += secondsSince(start);
+
+        if (!ok)
+            break;
+        ready_frames.push(frame);
+    }
+    ready_frames.close();
+}
+
+AsyncVideoWriter::~AsyncVideoWriter() {
+    release();
+}
+
+bool AsyncVideoWriter::open(const string &path, int fourcc, double fps, Size frame_size) {
+    if (!video.open(path, fourcc, fps, frame_size))
+        return false;
+
+    writer = thread(&AsyncVideoWriter::loop, this);
+    return true;
+}
+
+bool AsyncVideoWriter::isOpened() const {
+    return video.isOpened();
+}
+
+void AsyncVideoWriter::write(Mat *frame, Recycle recycle) {
+    if (!writer.joinable()) {
+        recycle(frame);
+        return;
+    }
+    jobs.push({ frame, move(recycle) });
+}
+
+void AsyncVideoWriter::release() {
+    jobs.close();
+    if (writer.joinable())
+        writer.join();
+    video.release();
+}
+
+double AsyncVideoWriter::encodeSeconds() const {
+    return encodeTime;
+}
+
+void AsyncVideoWriter::loop() {
+    Job job;
+    while (jobs.pop(job)) {
+        int64 start = getTickCount();
+        video.write(*job.frame);
+        encodeTime += secondsSince(start);
+
+        job.recycle(job.frame);
+    }
+}
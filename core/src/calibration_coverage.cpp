@@ -0,0 +1,112 @@
+#include <algorithm>
+#include <cmath>
+#include <opencv2/imgproc.hpp>
+#include "vision_core/calibration_coverage.h"
+
+using namespace cv;
+using namespace std;
+
+// apparent size of the board, sqrt(area of the board / area of the image): far, middle, near, very near
+static const double SCALE_EDGES[] = { 0.25, 0.4, 0.6 };
+static const int SCALE_BINS = 4;
+// |log(ratio of opposite sides)| beyond which the board is tilted around that axis, about 20 degrees
+static const double TILT_EDGE = 0.1;
+static const int TILT_BINS = 3;
+
+CalibrationFrameSelector::CalibrationFrameSelector(Size imageSize, Size boardSize, const CalibrationCoverageOptions &options)
+        : imageSize(imageSize), boardSize(boardSize), options(options) {
+    CV_Assert(boardSize.width >= 2 && boardSize.height >= 2);
+    cells = Mat::zeros(options.grid, CV_32S);
+    poses.assign(poseBins(), false);
+}
+
+int CalibrationFrameSelector::poseBins() {
+    return SCALE_BINS * TILT_BINS * TILT_BINS;
+}
+
+static int tiltBin(double a, double b) {
+    double r = log(max(a, 1e-6) / max(b, 1e-6));
+    return r < -TILT_EDGE ? 0 : (r > TILT_EDGE ? 2 : 1);
+}
+
+int CalibrationFrameSelector::poseBin(const vector<Point2f> &corners) const {
+    CV_Assert((int) corners.size() == boardSize.area());
+    const int w = boardSize.width, h = boardSize.height;
+    Point2f tl = corners[0], tr = corners[w - 1], bl = corners[(h - 1) * w], br = corners[h * w - 1];
+
+    vector<Point2f> quad = { tl, tr, br, bl };
+    double scale = sqrt(contourArea(quad) / imageSize.area());
+    int s = 0;
+    while (s < SCALE_BINS - 1 && scale >= SCALE_EDGES[s])
+        s++;
+
+    // a side further from the camera looks shorter than the opposite one
+    int tilt_x = tiltBin(norm(tr - tl), norm(br - bl));
+    int tilt_y = tiltBin(norm(bl - tl), norm(br - tr));
+    return (s * TILT_BINS + tilt_x) * TILT_BINS + tilt_y;
+}
+
+Point CalibrationFrameSelector::cellOf(const Point2f &p) const {
+    int cx = (int) (p.x * options.grid.width / imageSize.width);
+    int cy = (int) (p.y * options.grid.height / imageSize.height);
+    return Point(min(max(cx, 0), options.grid.width - 1), min(max(cy, 0), options.grid.height - 1));
+}
+
+int CalibrationFrameSelector::newCells(const vector<Point2f> &corners) const {
+    Mat reached = Mat::zeros(options.grid, CV_8U);
+    int count = 0;
+    for (const auto &c : corners) {
+        Point cell = cellOf(c);
+        if (cells.at<int>(cell) == 0 && !reached.at<uchar>(cell)) {
+            reached.at<uchar>(cell) = 1;
+            count++;
+        }
+    }
+    return count;
+}
+
+bool CalibrationFrameSelector::wouldAccept(const vector<Point2f> &corners) const {
+    if (full())
+        return false;
+    return !poses[poseBin(corners)] || newCells(corners) >= options.minNewCells;
+}
+
+void CalibrationFrameSelector::add(const vector<Point2f> &corners) {
+    Mat reached = Mat::zeros(options.grid, CV_8U);
+    for (const auto &c : corners)
+        reached.at<uchar>(cellOf(c)) = 1;
+    cv::add(cells, Scalar(1), cells, reached);
+
+    poses[poseBin(corners)] = true;
+    views++;
+}
+
+int CalibrationFrameSelector::accepted() const {
+    return views;
+}
+
+bool CalibrationFrameSelector::full() const {
+    return views >= options.budget;
+}
+
+double CalibrationFrameSelector::spatialCoverage() const {
+    return (double) countNonZero(cells) / cells.total();
+}
+
+int CalibrationFrameSelector::posesCovered() const {
+    return (int) count(poses.begin(), poses.end(), true);
+}
+
+void CalibrationFrameSelector::draw(Mat &frame) const {
+    for (int y = 0; y < options.grid.height; y++) {
+        for (int x = 0; x < options.grid.width; x++) {
+            if (cells.at<int>(y, x) == 0)
+                continue;
+            Rect cell(x * frame.cols / options.grid.width, y * frame.rows / options.grid.height,
+                      frame.cols / options.grid.width, frame.rows / options.grid.height);
+            Mat roi = frame(cell);
+            // 30% green
+            roi = roi * 0.7 + Scalar(0, 76, 0);
+        }
+    }
+}
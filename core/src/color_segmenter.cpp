@@ -0,0 +1,117 @@
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <opencv2/core/utility.hpp>
+#include <opencv2/imgproc.hpp>
+#include "vision_core/color_segmenter.h"
+#include "vision_core/pixel_kernels.h"
+#include "vision_core/trace.h"
+
+using namespace cv;
+using namespace std;
+
+ColorSegmenter::ColorSegmenter() : space(SEGMENT_BGR) {
+    memset(luts, 255, sizeof(luts));
+    updateRange();
+}
+
+void ColorSegmenter::setReference(Vec3b reference, Vec3i thresholds, ColorSpace space) {
+    this->space = space;
+
+    for (int c = 0; c < 3; c++) {
+        for (int v = 0; v < 256; v++) {
+            int distance = abs(v - reference[c]);
+            if (space == SEGMENT_HSV && c == 0)
+                distance = v < 180 ? min(distance, 180 - distance) : INT_MAX;
+            luts[c][v] = distance < thresholds[c] ? 255 : 0;
+        }
+    }
+
+    updateRange();
+}
+
+void ColorSegmenter::setLuts(const Mat luts[3], ColorSpace space) {
+    this->space = space;
+
+    for (int c = 0; c < 3; c++) {
+        CV_Assert(luts[c].type() == CV_8UC1 && luts[c].total() == 256 && luts[c].isContinuous());
+        const uchar *lut = luts[c].ptr<uchar>();
+        for (int v = 0; v < 256; v++)
+            this->luts[c][v] = lut[v] ? 255 : 0;
+    }
+
+    updateRange();
+}
+
+void ColorSegmenter::updateRange() {
+    isRange = true;
+
+    for (int c = 0; c < 3 && isRange; c++) {
+        int first = 0, last = 255;
+        while (first < 256 && !luts[c][first])
+            first++;
+        while (last >= 0 && !luts[c][last])
+            last--;
+
+        if (first > last) {
+            // nothing accepted: an empty interval
+            lower = Vec3b(1, 1, 1);
+            upper = Vec3b(0, 0, 0);
+            return;
+        }
+
+        for (int v = first; v <= last; v++) {
+            if (!luts[c][v])
+                isRange = false;
+        }
+        lower[c] = (uchar) first;
+        upper[c] = (uchar) last;
+    }
+}
+
+const Mat &ColorSegmenter::segment(const Mat &image, Rect roi) {
+    TRACE_SCOPE("core.color_segment");
+    CV_Assert(image.type() == CV_8UC3);
+
+    Rect bounds(Point(0, 0), image.size());
+    roi = roi == Rect() ? bounds : roi & bounds;
+    if (roi.empty()) {
+        // roi outside of the image: nothing to segment
+        mask.release();
+        return mask;
+    }
+
+    Mat src = image(roi);
+    if (space == SEGMENT_HSV) {
+        cvtColor(src, converted, COLOR_BGR2HSV);
+        src = converted;
+    }
+
+    if (isRange) {
+        colorRangeMask(src, mask, lower, upper);
+        return mask;
+    }
+
+    mask.create(src.size(), CV_8UC1);
+    parallel_for_(Range(0, src.rows), [&](const Range &rows) {
+        for (int row = rows.start; row < rows.end; row++) {
+            const uchar *p = src.ptr<uchar>(row);
+            uchar *m = mask.ptr<uchar>(row);
+            for (int col = 0; col < src.cols; col++, p += 3)
+                m[col] = luts[0][p[0]] & luts[1][p[1]] & luts[2][p[2]];
+        }
+    }, max(1.0, (double) src.total() / (1 << 16)));
+
+    return mask;
+}
+
+int ColorSegmenter::recolor(Mat &image, const Scalar &color, Rect roi) {
+    Rect bounds(Point(0, 0), image.size());
+    roi = roi == Rect() ? bounds : roi & bounds;
+    if (roi.empty())
+        return 0;
+
+    segment(image, roi);
+    image(roi).setTo(color, mask);
+    return countNonZero(mask);
+}
@@ -0,0 +1,222 @@
+#include <cstring>
+#include <opencv2/imgproc.hpp>
+#include "vision_core/edge_detector.h"
+
+using namespace cv;
+using namespace std;
+
+// Minimum rows per band, smaller bands spend most of their time on the halo rows
+const int MIN_BAND_ROWS = 16;
+
+// tan(22.5 deg) in Q15, as in cv::Canny
+const int TG22 = 13573;
+
+EdgeDetector::EdgeDetector(int bands) : requestedBands(bands) {
+}
+
+const Mat& EdgeDetector::gray() const {
+    return grayImg;
+}
+
+const Mat& EdgeDetector::gradientX() const {
+    return dx;
+}
+
+const Mat& EdgeDetector::gradientY() const {
+    return dy;
+}
+
+void EdgeDetector::detect(const Mat &src, Mat &edges, double low_threshold, double high_threshold) {
+    CV_Assert(src.depth() == CV_8U && (src.channels() == 1 || src.channels() == 3));
+
+    if (low_threshold > high_threshold)
+        swap(low_threshold, high_threshold);
+    int low = cvFloor(low_threshold);
+    int high = cvFloor(high_threshold);
+
+    allocate(src);
+
+    // Suppression of a band reads the magnitude of the neighbour bands, so the two passes can't be merged
+    parallel_for_(Range(0, (int) bands.size()), [&](const Range &range) {
+        for (int b = range.start; b < range.end; b++)
+            gradientBand(src, bands[b]);
+    });
+
+    parallel_for_(Range(0, (int) bands.size()), [&](const Range &range) {
+        for (int b = range.start; b < range.end; b++)
+            suppressBand(bands[b], low, high);
+    });
+
+    hysteresis();
+
+    compare(edgeMap, 2, edges, CMP_EQ);
+}
+
+/**
+ * (Re)allocates the buffers only if the image size changed since the last call.
+ */
+void EdgeDetector::allocate(const Mat &src) {
+    int n_bands = requestedBands > 0 ? requestedBands : getNumThreads();
+    n_bands = max(1, min(n_bands, src.rows / MIN_BAND_ROWS));
+
+    if (grayImg.size() == src.size() && bands.size() == n_bands)
+        return;
+
+    grayImg.create(src.size(), CV_8U);
+    dx.create(src.size(), CV_16S);
+    dy.create(src.size(), CV_16S);
+    direction.create(src.size(), CV_8U);
+    edgeMap.create(src.size(), CV_8U);
+    magnitude.create(src.rows + 2, src.cols + 2, CV_32S);
+    magnitude.setTo(0);
+
+    bands.resize(n_bands);
+    for (int b = 0; b < n_bands; b++) {
+        bands[b].startRow = src.rows * b / n_bands;
+        bands[b].endRow = src.rows * (b + 1) / n_bands;
+        bands[b].grayRows.create(3, src.cols + 2, CV_8U);
+    }
+}
+
+/**
+ * Converts row y of src (clamped inside the image) to gray into dst,
+ * replicating the first and last pixel in dst[0] and dst[cols + 1].
+ */
+static void grayRow(const Mat &src, int y, uchar *dst) {
+    y = min(max(y, 0), src.rows - 1);
+    const uchar *s = src.ptr<uchar>(y);
+    uchar *d = dst + 1;
+
+    if (src.channels() == 1) {
+        memcpy(d, s, src.cols);
+    } else {
+        // same fixed point coefficients as cv::cvtColor(COLOR_BGR2GRAY)
+        for (int x = 0; x < src.cols; x++, s += 3)
+            d[x] = (uchar) ((s[0] * 1868 + s[1] * 9617 + s[2] * 4899 + (1 << 13)) >> 14);
+    }
+
+    dst[0] = d[0];
+    dst[src.cols + 1] = d[src.cols - 1];
+}
+
+/**
+ * Sobel derivatives, L1 magnitude and quantized direction for the rows of the band.
+ * Direction: 0 horizontal gradient, 2 vertical gradient, 1 and 3 the two diagonals
+ * (1 when dx and dy have the same sign).
+ */
+void EdgeDetector::gradientBand(const Mat &src, Band &band) {
+    int cols = src.cols;
+    Mat &ring = band.grayRows;
+
+    // ring row holding image row y
+    auto slot = [&](int y) { return ring.ptr<uchar>((y - band.startRow + 1) % 3); };
+
+    // halo row above the band
+    grayRow(src, band.startRow - 1, slot(band.startRow - 1));
+    grayRow(src, band.startRow, slot(band.startRow));
+
+    for (int y = band.startRow; y < band.endRow; y++) {
+        // the last iteration converts the halo row below the band
+        grayRow(src, y + 1, slot(y + 1));
+
+        const uchar *p = slot(y - 1) + 1;
+        const uchar *c = slot(y) + 1;
+        const uchar *n = slot(y + 1) + 1;
+
+        memcpy(grayImg.ptr<uchar>(y), c, cols);
+
+        short *dx_row = dx.ptr<short>(y);
+        short *dy_row = dy.ptr<short>(y);
+        int *mag_row = magnitude.ptr<int>(y + 1) + 1;
+        uchar *dir_row = direction.ptr<uchar>(y);
+
+        for (int x = 0; x < cols; x++) {
+            int gx = (p[x+1] - p[x-1]) + 2 * (c[x+1] - c[x-1]) + (n[x+1] - n[x-1]);
+            int gy = (n[x-1] + 2 * n[x] + n[x+1]) - (p[x-1] + 2 * p[x] + p[x+1]);
+            int ax = abs(gx);
+            int ay = abs(gy);
+
+            dx_row[x] = (short) gx;
+            dy_row[x] = (short) gy;
+            mag_row[x] = ax + ay;
+
+            int tg22x = ax * TG22;
+            int ay15 = ay << 15;
+            if (ay15 < tg22x)
+                dir_row[x] = 0;
+            else if (ay15 > tg22x + (ax << 16))
+                dir_row[x] = 2;
+            else
+                dir_row[x] = (gx ^ gy) < 0 ? 3 : 1;
+        }
+    }
+}
+
+/**
+ * Non-maximum suppression and double threshold for the rows of the band.
+ */
+void EdgeDetector::suppressBand(Band &band, int low, int high) {
+    int cols = edgeMap.cols;
+    band.strong.clear();
+
+    for (int y = band.startRow; y < band.endRow; y++) {
+        const int *m_p = magnitude.ptr<int>(y) + 1;
+        const int *m_c = magnitude.ptr<int>(y + 1) + 1;
+        const int *m_n = magnitude.ptr<int>(y + 2) + 1;
+        const uchar *dir_row = direction.ptr<uchar>(y);
+        uchar *map_row = edgeMap.ptr<uchar>(y);
+
+        for (int x = 0; x < cols; x++) {
+            int m = m_c[x];
+            bool is_max = false;
+
+            if (m > low) {
+                switch (dir_row[x]) {
+                    case 0: is_max = m > m_c[x-1] && m >= m_c[x+1]; break;
+                    case 2: is_max = m > m_p[x] && m >= m_n[x]; break;
+                    case 1: is_max = m > m_p[x-1] && m > m_n[x+1]; break;
+                    default: is_max = m > m_p[x+1] && m > m_n[x-1]; break;
+                }
+            }
+
+            if (!is_max) {
+                map_row[x] = 0;
+            } else if (m > high) {
+                map_row[x] = 2;
+                band.strong.push_back(y * cols + x);
+            } else {
+                map_row[x] = 1;
+            }
+        }
+    }
+}
+
+/**
+ * Promotes to edges the weak pixels 8-connected to a strong one.
+ */
+void EdgeDetector::hysteresis() {
+    int rows = edgeMap.rows;
+    int cols = edgeMap.cols;
+    uchar *map = edgeMap.ptr<uchar>(0); // edgeMap is allocated by create() and is continuous
+
+    stack.clear();
+    for (const auto &band : bands)
+        stack.insert(stack.end(), band.strong.begin(), band.strong.end());
+
+    while (!stack.empty()) {
+        int idx = stack.back();
+        stack.pop_back();
+
+        int y = idx / cols;
+        int x = idx % cols;
+        for (int ny = max(y - 1, 0); ny <= min(y + 1, rows - 1); ny++) {
+            for (int nx = max(x - 1, 0); nx <= min(x + 1, cols - 1); nx++) {
+                int n_idx = ny * cols + nx;
+                if (map[n_idx] == 1) {
+                    map[n_idx] = 2;
+                    stack.push_back(n_idx);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,106 @@
+#include <opencv2/imgproc.hpp>
+#include "vision_core/equalization.h"
+#include "vision_core/trace.h"
+
+using namespace cv;
+using namespace std;
+
+void equalizeHSV(const Mat &src, Mat &dst, int channels) {
+    TRACE_SCOPE("core.equalize_hsv");
+
+    Mat hsv;
+    vector<Mat> channelsHSV(3);
+    cvtColor(src, hsv, COLOR_BGR2HSV);
+    split(hsv, channelsHSV);
+
+    for (int i = 0; i < 3; i++) {
+        if (channels & (1 << i))
+            equalizeHist(channelsHSV[i], channelsHSV[i]);
+    }
+
+    merge(channelsHSV, hsv);
+    cvtColor(hsv, dst, COLOR_HSV2BGR);
+}
+
+void equalizeBGR(const Mat &src, Mat &dst) {
+    TRACE_SCOPE("core.equalize_bgr");
+
+    vector<Mat> channels(3);
+    split(src, channels);
+    for (auto &c : channels)
+        equalizeHist(c, c);
+    merge(channels, dst);
+}
+
+HSVEqualizer::HSVEqualizer(int channels) : channels(channels) {
+    for (auto &h : histograms)
+        h = Mat::zeros(1, 256, CV_64F);
+}
+
+void HSVEqualizer::accumulate(const Mat &part) {
+    TRACE_SCOPE("core.equalize_accumulate");
+    cvtColor(part, hsv, COLOR_BGR2HSV);
+    cv::split(hsv, split);
+
+    for (int i = 0; i < 3; i++) {
+        if (!(channels & (1 << i)))
+            continue;
+        double *h = histograms[i].ptr<double>();
+        for (int y = 0; y < split[i].rows; y++) {
+            const uchar *p = split[i].ptr<uchar>(y);
+            for (int x = 0; x < split[i].cols; x++)
+                h[p[x]]++;
+        }
+    }
+    lutsReady = false;
+}
+
+// the table cv::equalizeHist builds from the histogram of the whole image
+static void equalizationLut(const Mat &histogram, Mat &lut) {
+    const double *h = histogram.ptr<double>();
+    lut.create(1, 256, CV_8U);
+    uchar *l = lut.ptr<uchar>();
+
+    double total = 0;
+    for (int i = 0; i < 256; i++)
+        total += h[i];
+
+    int first = 0;
+    while (first < 255 && h[first] == 0)
+        first++;
+
+    if (h[first] == total) {
+        lut.setTo(first);
+        return;
+    }
+
+    // float as in equalizeHist, for the same rounding
+    float scale = 255.f / (float) (total - h[first]);
+    double sum = 0;
+    for (int i = 0; i <= first; i++)
+        l[i] = 0;
+    for (int i = first + 1; i < 256; i++) {
+        sum += h[i];
+        l[i] = saturate_cast<uchar>((float) sum * scale);
+    }
+}
+
+void HSVEqualizer::apply(const Mat &src, Mat &dst) {
+    TRACE_SCOPE("core.equalize_apply");
+    if (!lutsReady) {
+        for (int i = 0; i < 3; i++) {
+            if (channels & (1 << i))
+                equalizationLut(histograms[i], luts[i]);
+        }
+        lutsReady = true;
+    }
+
+    cvtColor(src, hsv, COLOR_BGR2HSV);
+    cv::split(hsv, split);
+    for (int i = 0; i < 3; i++) {
+        if (channels & (1 << i))
+            LUT(split[i], luts[i], split[i]);
+    }
+    merge(split, hsv);
+    cvtColor(hsv, dst, COLOR_HSV2BGR);
+}
@@ -0,0 +1,17 @@
+#include <opencv2/core/version.hpp>
+#include "vision_core/features.h"
+
+#if CV_VERSION_MAJOR < 4 || (CV_VERSION_MAJOR == 4 && CV_VERSION_MINOR < 4)
+#include <opencv2/xfeatures2d.hpp>
+#define VISION_CORE_CONTRIB_SIFT
+#endif
+
+using namespace cv;
+
+Ptr<Feature2D> createSiftDetector() {
+#ifdef VISION_CORE_CONTRIB_SIFT
+    return xfeatures2d::SIFT::create();
+#else
+    return SIFT::create();
+#endif
+}
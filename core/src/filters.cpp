@@ -0,0 +1,54 @@
+#include <opencv2/imgproc.hpp>
+#include "vision_core/filters.h"
+#include "vision_core/trace.h"
+
+using namespace cv;
+
+Filter::Filter(const Mat &input_img, int size) : input_image(input_img) {
+    setSize(size);
+}
+
+void Filter::doFilter() {
+    input_image.copyTo(result_image);
+}
+
+void Filter::setSize(int size) {
+    // the window needs a center pixel
+    if (size % 2 == 0)
+        size++;
+    filter_size = size;
+}
+
+GaussianFilter::GaussianFilter(const Mat &input_img, int filter_size, double sigma)
+    : Filter(input_img, filter_size), sigma(sigma) {
+}
+
+void GaussianFilter::doFilter() {
+    TRACE_SCOPE("core.gaussian_filter");
+    GaussianBlur(input_image, result_image, Size(filter_size, filter_size), sigma, sigma);
+}
+
+MedianFilter::MedianFilter(const Mat &input_img, int filter_size) : Filter(input_img, filter_size) {
+}
+
+void MedianFilter::doFilter() {
+    TRACE_SCOPE("core.median_filter");
+    medianBlur(input_image, result_image, filter_size);
+}
+
+BilateralFilter::BilateralFilter(const Mat &input_img, double sigma_range, double sigma_space)
+    : Filter(input_img, 1) {
+    setSigmas(sigma_range, sigma_space);
+}
+
+void BilateralFilter::setSigmas(double sigma_range, double sigma_space) {
+    sigmaRange = sigma_range;
+    sigmaSpace = sigma_space;
+    // bilateralFilter takes the diameter, it doesn't need to be odd
+    filter_size = cvRound(6 * sigma_space);
+}
+
+void BilateralFilter::doFilter() {
+    TRACE_SCOPE("core.bilateral_filter");
+    bilateralFilter(input_image, result_image, filter_size, sigmaRange, sigmaSpace);
+}
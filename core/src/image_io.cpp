@@ -0,0 +1,154 @@
+#include <algorithm>
+#include "vision_core/image_io.h"
+#include "vision_core/trace.h"
+
+using namespace cv;
+using namespace std;
+
+vector<string> listImages(const string &pattern) {
+    vector<String> found;
+    glob(pattern, found);
+
+    vector<string> paths(found.begin(), found.end());
+    sort(paths.begin(), paths.end());
+    return paths;
+}
+
+ImageFolderLoader::ImageFolderLoader(const string &pattern, const ImageLoadOptions &options)
+        : paths(listImages(pattern)), options(options) {
+    start();
+}
+
+ImageFolderLoader::ImageFolderLoader(vector<string> paths, const ImageLoadOptions &options)
+        : paths(std::move(paths)), options(options) {
+    start();
+}
+
+void ImageFolderLoader::start() {
+    if (options.threads <= 0)
+        options.threads = max(1, getNumThreads());
+    if (options.prefetch <= 0)
+        options.prefetch = 2 * options.threads;
+
+    int threads = (int) min((size_t) options.threads, paths.size());
+    for (int i = 0; i < threads; i++)
+        workers.emplace_back(&ImageFolderLoader::work, this);
+}
+
+ImageFolderLoader::~ImageFolderLoader() {
+    {
+        lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    changed.notify_all();
+    for (auto &w : workers)
+        w.join();
+}
+
+void ImageFolderLoader::work() {
+    while (true) {
+        size_t index;
+        {
+            unique_lock<std::mutex> lock(mutex);
+            // bounded prefetch: wait for the caller to consume before decoding too far ahead
+            changed.wait(lock, [this] {
+                return stopping || claimed >= paths.size() || claimed < consumed + options.prefetch;
+            });
+            if (stopping || claimed >= paths.size())
+                return;
+            index = claimed++;
+        }
+
+        Mat image;
+        try {
+            {
+                TRACE_SCOPE("core.imread");
+                image = imread(paths[index], options.flags);
+            }
+            if (!image.empty() && options.transform)
+                options.transform(image);
+        } catch (...) {
+            // whatever imread or the transform throws (cv::Exception, std::bad_alloc...): skipped like an
+            // unreadable file, the thread must not die with the slot unfilled
+            image.release();
+        }
+
+        {
+            lock_guard<std::mutex> lock(mutex);
+            decoded[index] = image;
+        }
+        changed.notify_all();
+    }
+}
+
+size_t ImageFolderLoader::size() const {
+    return paths.size();
+}
+
+bool ImageFolderLoader::next(Mat &image, string *path) {
+    unique_lock<std::mutex> lock(mutex);
+    while (consumed < paths.size()) {
+        {
+            TRACE_SCOPE("core.image_loader_wait");
+            changed.wait(lock, [this] { return decoded.count(consumed) > 0; });
+        }
+        auto found = decoded.find(consumed);
+        Mat result = found->second;
+        decoded.erase(found);
+        size_t index = consumed++;
+        // a slot of the prefetch window is free
+        changed.notify_all();
+
+        if (result.empty())
+            continue;
+
+        image = result;
+        if (path)
+            *path = paths[index];
+        return true;
+    }
+    return false;
+}
+
+ImageFolderLoader::iterator::iterator(ImageFolderLoader *loader) : loader(loader) {
+    if (loader)
+        ++*this;
+}
+
+ImageFolderLoader::iterator &ImageFolderLoader::iterator::operator++() {
+    if (loader && !loader->next(current.image, &current.path))
+        loader = nullptr;
+    return *this;
+}
+
+ImageFolderLoader::iterator ImageFolderLoader::begin() {
+    return iterator(this);
+}
+
+ImageFolderLoader::iterator ImageFolderLoader::end() {
+    return iterator();
+}
+
+int loadImages(const string &pattern, vector<Mat> &images, vector<string> *paths, const ImageLoadOptions &options) {
+    TRACE_SCOPE("core.load_images");
+    images.clear();
+    if (paths)
+        paths->clear();
+
+    ImageFolderLoader loader(pattern, options);
+    Mat img;
+    string path;
+    while (loader.next(img, &path)) {
+        images.push_back(img);
+        if (paths)
+            paths->push_back(path);
+    }
+
+    return images.size();
+}
+
+int loadImages(const string &pattern, vector<Mat> &images, vector<string> *paths, int flags) {
+    ImageLoadOptions options;
+    options.flags = flags;
+    return loadImages(pattern, images, paths, options);
+}
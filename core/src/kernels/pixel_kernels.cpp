@@ -0,0 +1,126 @@
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <opencv2/core/utility.hpp>
+#include "vision_core/pixel_kernels.h"
+#include "pixel_kernels_impl.h"
+
+using namespace cv;
+using namespace std;
+
+static const kernels::PixelKernels *kernelTable(KernelIsa isa) {
+    switch (isa) {
+        case KERNEL_SCALAR:
+            return &kernels::scalarKernels;
+#ifdef VISION_CORE_HAVE_SSE41
+        case KERNEL_SSE41:
+            return checkHardwareSupport(CV_CPU_SSE4_1) ? &kernels::sse41Kernels : nullptr;
+#endif
+#ifdef VISION_CORE_HAVE_AVX2
+        case KERNEL_AVX2:
+            return checkHardwareSupport(CV_CPU_AVX2) ? &kernels::avx2Kernels : nullptr;
+#endif
+#ifdef VISION_CORE_HAVE_AVX512
+        case KERNEL_AVX512:
+            return checkHardwareSupport(CV_CPU_AVX512_SKX) ? &kernels::avx512Kernels : nullptr;
+#endif
+#ifdef VISION_CORE_HAVE_NEON
+        case KERNEL_NEON:
+            return checkHardwareSupport(CV_CPU_NEON) ? &kernels::neonKernels : nullptr;
+#endif
+        default:
+            return nullptr;
+    }
+}
+
+static const KernelIsa allIsas[] = { KERNEL_SCALAR, KERNEL_SSE41, KERNEL_AVX2, KERNEL_AVX512, KERNEL_NEON };
+
+static KernelIsa selectKernelIsa() {
+    vector<KernelIsa> supported = supportedKernelIsas();
+
+    const char *forced = getenv("CVLAB_KERNEL_ISA");
+    if (forced && *forced) {
+        for (KernelIsa isa : supported) {
+            if (strcmp(forced, kernelIsaName(isa)) == 0)
+                return isa;
+        }
+        cerr << "CVLAB_KERNEL_ISA: " << forced << " is not supported, using " << kernelIsaName(supported.back()) << endl;
+    }
+
+    return supported.back();
+}
+
+static atomic<KernelIsa> &currentIsa() {
+    static atomic<KernelIsa> isa(selectKernelIsa());
+    return isa;
+}
+
+static const kernels::PixelKernels &active() {
+    return *kernelTable(currentIsa().load(memory_order_relaxed));
+}
+
+const char *kernelIsaName(KernelIsa isa) {
+    switch (isa) {
+        case KERNEL_SCALAR: return "scalar";
+        case KERNEL_SSE41: return "sse4.1";
+        case KERNEL_AVX2: return "avx2";
+        case KERNEL_AVX512: return "avx512";
+        case KERNEL_NEON: return "neon";
+    }
+    return "unknown";
+}
+
+vector<KernelIsa> supportedKernelIsas() {
+    vector<KernelIsa> supported;
+    for (KernelIsa isa : allIsas) {
+        if (kernelTable(isa))
+            supported.push_back(isa);
+    }
+    return supported;
+}
+
+KernelIsa activeKernelIsa() {
+    return currentIsa().load();
+}
+
+bool setKernelIsa(KernelIsa isa) {
+    if (!kernelTable(isa))
+        return false;
+    currentIsa().store(isa);
+    return true;
+}
+
+// one stripe per ~64K pixels, small ROIs (Lab1 window) run on the calling thread
+static double stripes(const Mat &m) {
+    return max(1.0, (double) m.total() / (1 << 16));
+}
+
+void colorRangeMask(const Mat &src, Mat &mask, Vec3b lower, Vec3b upper) {
+    CV_Assert(src.type() == CV_8UC3);
+    mask.create(src.size(), CV_8UC1);
+
+    const kernels::ColorRangeRow colorRange = active().colorRange;
+    const uint8_t lo[3] = { lower[0], lower[1], lower[2] };
+    const uint8_t hi[3] = { upper[0], upper[1], upper[2] };
+
+    parallel_for_(Range(0, src.rows), [&](const Range &rows) {
+        for (int row = rows.start; row < rows.end; row++)
+            colorRange(src.ptr<uint8_t>(row), mask.ptr<uint8_t>(row), src.cols, lo, hi);
+    }, stripes(src));
+}
+
+void gatherPixels(const Mat &src, const Mat &offsets, Mat &dst) {
+    CV_Assert(src.type() == CV_8UC3 && src.isContinuous() && offsets.type() == CV_32SC1);
+    dst.create(offsets.size(), CV_8UC3);
+    CV_Assert(src.data != dst.data);
+
+    const kernels::GatherPixels3Row gather3 = active().gather3;
+    const uint8_t *data = src.ptr<uint8_t>();
+    const int64_t bytes = (int64_t) src.total() * 3;
+
+    parallel_for_(Range(0, offsets.rows), [&](const Range &rows) {
+        for (int row = rows.start; row < rows.end; row++)
+            gather3(data, bytes, offsets.ptr<int32_t>(row), dst.ptr<uint8_t>(row), offsets.cols);
+    }, stripes(offsets));
+}
@@ -0,0 +1,86 @@
+#include <immintrin.h>
+#include "pixel_kernels_impl.h"
+
+namespace kernels {
+
+    // two lanes of 16 pixels each: same pshufb masks as the SSE4.1 version, applied to both lanes
+    static inline __m256i load2x128(const uint8_t *lo, const uint8_t *hi) {
+        return _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i*) lo)),
+                                       _mm_loadu_si128((const __m128i*) hi), 1);
+    }
+
+    static inline __m256i mask2x(char m0, char m1, char m2, char m3, char m4, char m5, char m6, char m7,
+                                 char m8, char m9, char m10, char m11, char m12, char m13, char m14, char m15) {
+        return _mm256_broadcastsi128_si256(_mm_setr_epi8(m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12, m13, m14, m15));
+    }
+
+    static inline void deinterleave3(const uint8_t *p, __m256i &b, __m256i &g, __m256i &r) {
+        const __m256i b0 = mask2x(0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+        const __m256i b1 = mask2x(-1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14, -1, -1, -1, -1, -1);
+        const __m256i b2 = mask2x(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1, 4, 7, 10, 13);
+        const __m256i g0 = mask2x(1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+        const __m256i g1 = mask2x(-1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1);
+        const __m256i g2 = mask2x(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14);
+        const __m256i r0 = mask2x(2, 5, 8, 11, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+        const __m256i r1 = mask2x(-1, -1, -1, -1, -1, 1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1);
+        const __m256i r2 = mask2x(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15);
+
+        // lane 0 holds pixels 0-15, lane 1 pixels 16-31
+        __m256i v0 = load2x128(p, p + 48);
+        __m256i v1 = load2x128(p + 16, p + 64);
+        __m256i v2 = load2x128(p + 32, p + 80);
+
+        b = _mm256_or_si256(_mm256_or_si256(_mm256_shuffle_epi8(v0, b0), _mm256_shuffle_epi8(v1, b1)), _mm256_shuffle_epi8(v2, b2));
+        g = _mm256_or_si256(_mm256_or_si256(_mm256_shuffle_epi8(v0, g0), _mm256_shuffle_epi8(v1, g1)), _mm256_shuffle_epi8(v2, g2));
+        r = _mm256_or_si256(_mm256_or_si256(_mm256_shuffle_epi8(v0, r0), _mm256_shuffle_epi8(v1, r1)), _mm256_shuffle_epi8(v2, r2));
+    }
+
+    static inline __m256i outside(__m256i v, __m256i lower, __m256i upper) {
+        return _mm256_or_si256(_mm256_subs_epu8(lower, v), _mm256_subs_epu8(v, upper));
+    }
+
+    static void colorRange(const uint8_t *src, uint8_t *mask, int width, const uint8_t lower[3], const uint8_t upper[3]) {
+        const __m256i lb = _mm256_set1_epi8((char) lower[0]), ub = _mm256_set1_epi8((char) upper[0]);
+        const __m256i lg = _mm256_set1_epi8((char) lower[1]), ug = _mm256_set1_epi8((char) upper[1]);
+        const __m256i lr = _mm256_set1_epi8((char) lower[2]), ur = _mm256_set1_epi8((char) upper[2]);
+        const __m256i zero = _mm256_setzero_si256();
+
+        int x = 0;
+        for (; x + 32 <= width; x += 32) {
+            __m256i b, g, r;
+            deinterleave3(src + 3 * x, b, g, r);
+
+            __m256i out = _mm256_or_si256(_mm256_or_si256(outside(b, lb, ub), outside(g, lg, ug)), outside(r, lr, ur));
+            _mm256_storeu_si256((__m256i*) (mask + x), _mm256_cmpeq_epi8(out, zero));
+        }
+
+        colorRangeScalar(src, mask, x, width, lower, upper);
+    }
+
+    static void gather3(const uint8_t *src, int64_t src_bytes, const int32_t *offsets, uint8_t *dst, int width) {
+        const __m256i pack = mask2x(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+        // 12 bytes of lane 0 then 12 bytes of lane 1
+        const __m256i compact = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7);
+        const __m256i limit = _mm256_set1_epi32((int) (src_bytes - 4 > 0x7fffffff ? 0x7fffffff : src_bytes - 4));
+
+        int x = 0;
+        for (; x + 8 <= width; x += 8) {
+            __m256i idx = _mm256_loadu_si256((const __m256i*) (offsets + x));
+            if (_mm256_movemask_epi8(_mm256_cmpgt_epi32(idx, limit))) {
+                gather3Scalar(src, offsets, dst, x, x + 8);
+                continue;
+            }
+
+            __m256i v = _mm256_i32gather_epi32((const int*) src, idx, 1);
+            v = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(v, pack), compact);
+
+            uint8_t *d = dst + 3 * x;
+            _mm_storeu_si128((__m128i*) d, _mm256_castsi256_si128(v));
+            _mm_storel_epi64((__m128i*) (d + 16), _mm256_extracti128_si256(v, 1));
+        }
+
+        gather3Scalar(src, offsets, dst, x, width);
+    }
+
+    extern const PixelKernels avx2Kernels = { "avx2", colorRange, gather3 };
+}
@@ -0,0 +1,85 @@
+#include <immintrin.h>
+#include "pixel_kernels_impl.h"
+
+namespace kernels {
+
+    // four lanes of 16 pixels each, pshufb works inside each 128-bit lane
+    static inline __m512i load4x128(const uint8_t *p) {
+        __m512i v = _mm512_castsi128_si512(_mm_loadu_si128((const __m128i*) p));
+        v = _mm512_inserti32x4(v, _mm_loadu_si128((const __m128i*) (p + 48)), 1);
+        v = _mm512_inserti32x4(v, _mm_loadu_si128((const __m128i*) (p + 96)), 2);
+        return _mm512_inserti32x4(v, _mm_loadu_si128((const __m128i*) (p + 144)), 3);
+    }
+
+    static inline __m512i mask4x(char m0, char m1, char m2, char m3, char m4, char m5, char m6, char m7,
+                                 char m8, char m9, char m10, char m11, char m12, char m13, char m14, char m15) {
+        return _mm512_broadcast_i32x4(_mm_setr_epi8(m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12, m13, m14, m15));
+    }
+
+    static inline void deinterleave3(const uint8_t *p, __m512i &b, __m512i &g, __m512i &r) {
+        const __m512i b0 = mask4x(0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+        const __m512i b1 = mask4x(-1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14, -1, -1, -1, -1, -1);
+        const __m512i b2 = mask4x(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1, 4, 7, 10, 13);
+        const __m512i g0 = mask4x(1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+        const __m512i g1 = mask4x(-1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1);
+        const __m512i g2 = mask4x(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14);
+        const __m512i r0 = mask4x(2, 5, 8, 11, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+        const __m512i r1 = mask4x(-1, -1, -1, -1, -1, 1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1);
+        const __m512i r2 = mask4x(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15);
+
+        __m512i v0 = load4x128(p);
+        __m512i v1 = load4x128(p + 16);
+        __m512i v2 = load4x128(p + 32);
+
+        b = _mm512_or_si512(_mm512_or_si512(_mm512_shuffle_epi8(v0, b0), _mm512_shuffle_epi8(v1, b1)), _mm512_shuffle_epi8(v2, b2));
+        g = _mm512_or_si512(_mm512_or_si512(_mm512_shuffle_epi8(v0, g0), _mm512_shuffle_epi8(v1, g1)), _mm512_shuffle_epi8(v2, g2));
+        r = _mm512_or_si512(_mm512_or_si512(_mm512_shuffle_epi8(v0, r0), _mm512_shuffle_epi8(v1, r1)), _mm512_shuffle_epi8(v2, r2));
+    }
+
+    static inline __m512i outside(__m512i v, __m512i lower, __m512i upper) {
+        return _mm512_or_si512(_mm512_subs_epu8(lower, v), _mm512_subs_epu8(v, upper));
+    }
+
+    static void colorRange(const uint8_t *src, uint8_t *mask, int width, const uint8_t lower[3], const uint8_t upper[3]) {
+        const __m512i lb = _mm512_set1_epi8((char) lower[0]), ub = _mm512_set1_epi8((char) upper[0]);
+        const __m512i lg = _mm512_set1_epi8((char) lower[1]), ug = _mm512_set1_epi8((char) upper[1]);
+        const __m512i lr = _mm512_set1_epi8((char) lower[2]), ur = _mm512_set1_epi8((char) upper[2]);
+
+        int x = 0;
+        for (; x + 64 <= width; x += 64) {
+            __m512i b, g, r;
+            deinterleave3(src + 3 * x, b, g, r);
+
+            __m512i out = _mm512_or_si512(_mm512_or_si512(outside(b, lb, ub), outside(g, lg, ug)), outside(r, lr, ur));
+            __mmask64 in = _mm512_testn_epi8_mask(out, out);
+            _mm512_storeu_si512((void*) (mask + x), _mm512_movm_epi8(in));
+        }
+
+        colorRangeScalar(src, mask, x, width, lower, upper);
+    }
+
+    static void gather3(const uint8_t *src, int64_t src_bytes, const int32_t *offsets, uint8_t *dst, int width) {
+        const __m512i pack = mask4x(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+        // 12 bytes of each lane, one after the other
+        const __m512i compact = _mm512_setr_epi32(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, 3, 7, 11, 15);
+        const __m512i limit = _mm512_set1_epi32((int) (src_bytes - 4 > 0x7fffffff ? 0x7fffffff : src_bytes - 4));
+        const __mmask64 store48 = 0x0000FFFFFFFFFFFFULL;
+
+        int x = 0;
+        for (; x + 16 <= width; x += 16) {
+            __m512i idx = _mm512_loadu_si512((const void*) (offsets + x));
+            if (_mm512_cmpgt_epi32_mask(idx, limit)) {
+                gather3Scalar(src, offsets, dst, x, x + 16);
+                continue;
+            }
+
+            __m512i v = _mm512_i32gather_epi32(idx, (const void*) src, 1);
+            v = _mm512_permutexvar_epi32(compact, _mm512_shuffle_epi8(v, pack));
+            _mm512_mask_storeu_epi8((void*) (dst + 3 * x), store48, v);
+        }
+
+        gather3Scalar(src, offsets, dst, x, width);
+    }
+
+    extern const PixelKernels avx512Kernels = { "avx512", colorRange, gather3 };
+}
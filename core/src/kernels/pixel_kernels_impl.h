@@ -0,0 +1,77 @@
+#ifndef VISION_CORE_PIXEL_KERNELS_IMPL_H
+#define VISION_CORE_PIXEL_KERNELS_IMPL_H
+
+#include <cstdint>
+#include <cstring>
+
+/**
+ * Row kernels compiled once per instruction set (pixel_kernels_<isa>.cpp, each with its own compiler flags)
+ * and selected at runtime by pixel_kernels.cpp.
+ *
+ * The per-ISA files must only include this header and the intrinsics headers: an inline function
+ * (e.g. from OpenCV or the STL) instantiated in an AVX2 file could be picked by the linker for the
+ * whole program and crash on CPUs without AVX2. Helpers shared by the files are static for the same reason.
+ */
+namespace kernels {
+
+    /**
+     * mask[x] = 255 if lower[c] <= src[3x + c] <= upper[c] for each channel c, 0 otherwise.
+     */
+    typedef void (*ColorRangeRow)(const uint8_t *src, uint8_t *mask, int width, const uint8_t lower[3], const uint8_t upper[3]);
+
+    /**
+     * Copies 3-byte pixels: dst[3x .. 3x+2] = src[offsets[x] .. offsets[x]+2].
+     * src_bytes is the size of src, SIMD versions read 4 bytes per pixel and fall back to scalar near its end.
+     */
+    typedef void (*GatherPixels3Row)(const uint8_t *src, int64_t src_bytes, const int32_t *offsets, uint8_t *dst, int width);
+
+    struct PixelKernels {
+        const char *name;
+        ColorRangeRow colorRange;
+        GatherPixels3Row gather3;
+    };
+
+    extern const PixelKernels scalarKernels;
+#ifdef VISION_CORE_HAVE_SSE41
+    extern const PixelKernels sse41Kernels;
+#endif
+#ifdef VISION_CORE_HAVE_AVX2
+    extern const PixelKernels avx2Kernels;
+#endif
+#ifdef VISION_CORE_HAVE_AVX512
+    extern const PixelKernels avx512Kernels;
+#endif
+#ifdef VISION_CORE_HAVE_NEON
+    extern const PixelKernels neonKernels;
+#endif
+
+    // scalar code for the tails of the SIMD loops, and the reference implementation
+
+    static inline void colorRangeScalar(const uint8_t *src, uint8_t *mask, int from, int to,
+                                        const uint8_t lower[3], const uint8_t upper[3]) {
+        for (int x = from; x < to; x++) {
+            const uint8_t *p = src + 3 * x;
+            bool in = p[0] >= lower[0] && p[0] <= upper[0] &&
+                      p[1] >= lower[1] && p[1] <= upper[1] &&
+                      p[2] >= lower[2] && p[2] <= upper[2];
+            mask[x] = in ? 255 : 0;
+        }
+    }
+
+    static inline void gather3Scalar(const uint8_t *src, const int32_t *offsets, uint8_t *dst, int from, int to) {
+        for (int x = from; x < to; x++) {
+            const uint8_t *p = src + offsets[x];
+            dst[3 * x] = p[0];
+            dst[3 * x + 1] = p[1];
+            dst[3 * x + 2] = p[2];
+        }
+    }
+
+    static inline uint32_t load32(const uint8_t *p) {
+        uint32_t v;
+        memcpy(&v, p, 4);
+        return v;
+    }
+}
+
+#endif //VISION_CORE_PIXEL_KERNELS_IMPL_H
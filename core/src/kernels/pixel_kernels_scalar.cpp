@@ -0,0 +1,14 @@
+#include "pixel_kernels_impl.h"
+
+namespace kernels {
+
+    static void colorRange(const uint8_t *src, uint8_t *mask, int width, const uint8_t lower[3], const uint8_t upper[3]) {
+        colorRangeScalar(src, mask, 0, width, lower, upper);
+    }
+
+    static void gather3(const uint8_t *src, int64_t /* src_bytes */, const int32_t *offsets, uint8_t *dst, int width) {
+        gather3Scalar(src, offsets, dst, 0, width);
+    }
+
+    extern const PixelKernels scalarKernels = { "scalar", colorRange, gather3 };
+}
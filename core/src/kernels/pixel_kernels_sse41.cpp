@@ -0,0 +1,79 @@
+#include <smmintrin.h>
+#include "pixel_kernels_impl.h"
+
+namespace kernels {
+
+    // pshufb masks moving the bytes of channel c of 16 BGR pixels (3 registers) into one register
+    static inline void deinterleave3(const uint8_t *p, __m128i &b, __m128i &g, __m128i &r) {
+        const __m128i b0 = _mm_setr_epi8(0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+        const __m128i b1 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14, -1, -1, -1, -1, -1);
+        const __m128i b2 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1, 4, 7, 10, 13);
+        const __m128i g0 = _mm_setr_epi8(1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+        const __m128i g1 = _mm_setr_epi8(-1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1);
+        const __m128i g2 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14);
+        const __m128i r0 = _mm_setr_epi8(2, 5, 8, 11, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+        const __m128i r1 = _mm_setr_epi8(-1, -1, -1, -1, -1, 1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1);
+        const __m128i r2 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15);
+
+        __m128i v0 = _mm_loadu_si128((const __m128i*) p);
+        __m128i v1 = _mm_loadu_si128((const __m128i*) (p + 16));
+        __m128i v2 = _mm_loadu_si128((const __m128i*) (p + 32));
+
+        b = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(v0, b0), _mm_shuffle_epi8(v1, b1)), _mm_shuffle_epi8(v2, b2));
+        g = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(v0, g0), _mm_shuffle_epi8(v1, g1)), _mm_shuffle_epi8(v2, g2));
+        r = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(v0, r0), _mm_shuffle_epi8(v1, r1)), _mm_shuffle_epi8(v2, r2));
+    }
+
+    // non zero bytes where v is outside [lower, upper]
+    static inline __m128i outside(__m128i v, __m128i lower, __m128i upper) {
+        return _mm_or_si128(_mm_subs_epu8(lower, v), _mm_subs_epu8(v, upper));
+    }
+
+    static void colorRange(const uint8_t *src, uint8_t *mask, int width, const uint8_t lower[3], const uint8_t upper[3]) {
+        const __m128i lb = _mm_set1_epi8((char) lower[0]), ub = _mm_set1_epi8((char) upper[0]);
+        const __m128i lg = _mm_set1_epi8((char) lower[1]), ug = _mm_set1_epi8((char) upper[1]);
+        const __m128i lr = _mm_set1_epi8((char) lower[2]), ur = _mm_set1_epi8((char) upper[2]);
+        const __m128i zero = _mm_setzero_si128();
+
+        int x = 0;
+        for (; x + 16 <= width; x += 16) {
+            __m128i b, g, r;
+            deinterleave3(src + 3 * x, b, g, r);
+
+            __m128i out = _mm_or_si128(_mm_or_si128(outside(b, lb, ub), outside(g, lg, ug)), outside(r, lr, ur));
+            _mm_storeu_si128((__m128i*) (mask + x), _mm_cmpeq_epi8(out, zero));
+        }
+
+        colorRangeScalar(src, mask, x, width, lower, upper);
+    }
+
+    static void gather3(const uint8_t *src, int64_t src_bytes, const int32_t *offsets, uint8_t *dst, int width) {
+        // BGRx BGRx BGRx BGRx -> 12 packed bytes
+        const __m128i pack = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+        const int64_t limit = src_bytes - 4;
+
+        int x = 0;
+        for (; x + 4 <= width; x += 4) {
+            const int32_t *o = offsets + x;
+            if (o[0] > limit || o[1] > limit || o[2] > limit || o[3] > limit) {
+                gather3Scalar(src, offsets, dst, x, x + 4);
+                continue;
+            }
+
+            __m128i v = _mm_cvtsi32_si128((int) load32(src + o[0]));
+            v = _mm_insert_epi32(v, (int) load32(src + o[1]), 1);
+            v = _mm_insert_epi32(v, (int) load32(src + o[2]), 2);
+            v = _mm_insert_epi32(v, (int) load32(src + o[3]), 3);
+            v = _mm_shuffle_epi8(v, pack);
+
+            uint8_t *d = dst + 3 * x;
+            _mm_storel_epi64((__m128i*) d, v);
+            uint32_t last = (uint32_t) _mm_extract_epi32(v, 2);
+            memcpy(d + 8, &last, 4);
+        }
+
+        gather3Scalar(src, offsets, dst, x, width);
+    }
+
+    extern const PixelKernels sse41Kernels = { "sse4.1", colorRange, gather3 };
+}
@@ -0,0 +1,206 @@
+#include <iostream>
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+#include <opencv2/calib3d.hpp>
+#include <opencv2/flann.hpp>
+#include "vision_core/features.h"
+#include "vision_core/image_io.h"
+#include "vision_core/object_model_registry.h"
+#include "vision_core/trace.h"
+
+using namespace std;
+using namespace cv;
+
+ObjectModelRegistry::ObjectModelRegistry() {
+    detector = createSiftDetector();
+}
+
+int ObjectModelRegistry::add(const string &name, const Mat &image) {
+    ObjectModel model;
+    model.name = name;
+    model.size = image.size();
+    extract(image, model.keypoints, model.descriptors);
+    train(model);
+
+    models.push_back(model);
+    return models.size() - 1;
+}
+
+int ObjectModelRegistry::addImages(const string &pattern, Size blur_size, double blur_sigma) {
+    // decoded and blurred on the loader threads while the features of the previous images are extracted
+    ImageLoadOptions options;
+    options.transform = [blur_size, blur_sigma](Mat &img) { GaussianBlur(img, img, blur_size, blur_sigma, blur_sigma); };
+
+    int added = 0;
+    for (const auto &loaded : ImageFolderLoader(pattern, options)) {
+        add(loaded.path, loaded.image);
+        added++;
+    }
+
+    return added;
+}
+
+void ObjectModelRegistry::loadOrAddImages(const string &model_path, const string &pattern, Size blur_size, double blur_sigma) {
+    if (!model_path.empty() && load(model_path)) {
+        cout << "Loaded " << size() << " objects from " << model_path << endl;
+    } else {
+        addImages(pattern, blur_size, blur_sigma);
+
+        if (!model_path.empty() && !save(model_path))
+            cout << "Can't write objects model to " << model_path << endl;
+    }
+
+    buildIndex();
+}
+
+void ObjectModelRegistry::extract(const Mat &img, vector<KeyPoint> &keypoints, Mat &descriptors) {
+    TRACE_SCOPE("lab6.sift_detect_compute");
+    detector->detectAndCompute(img, noArray(), keypoints, descriptors);
+}
+
+void ObjectModelRegistry::match(int id, const Mat &frame_descriptors, vector<DMatch> &matches) const {
+    matches.clear();
+    if (frame_descriptors.empty() || models[id].descriptors.rows < 2)
+        return;
+
+    TRACE_SCOPE("lab6.bf_match");
+    vector<vector<DMatch>> knn_matches;
+    models[id].matcher->knnMatch(frame_descriptors, knn_matches, 2);
+
+    // Many frame keypoints don't belong to the object, keep only the unambiguous matches
+    for (const auto &m : knn_matches) {
+        if (m.size() == 2 && m[0].distance < matchRatio * m[1].distance)
+            matches.push_back(m[0]);
+    }
+}
+
+void ObjectModelRegistry::buildIndex() {
+    combinedMatcher = makePtr<FlannBasedMatcher>(makePtr<flann::KDTreeIndexParams>(4), makePtr<flann::SearchParams>(64));
+    indexObjects.clear();
+
+    for (int i = 0; i < models.size(); i++) {
+        if (models[i].descriptors.empty())
+            continue;
+        combinedMatcher->add(vector<Mat>({ models[i].descriptors }));
+        indexObjects.push_back(i);
+    }
+
+    if (!indexObjects.empty())
+        combinedMatcher->train();
+}
+
+void ObjectModelRegistry::matchAll(const Mat &frame_descriptors, vector<vector<DMatch>> &matches) const {
+    // buildIndex() must be called before matchAll()
+    CV_Assert(combinedMatcher);
+
+    matches.assign(models.size(), vector<DMatch>());
+    if (frame_descriptors.empty() || indexObjects.empty())
+        return;
+
+    TRACE_SCOPE("lab6.flann_match_all");
+    vector<vector<DMatch>> knn_matches;
+    combinedMatcher->knnMatch(frame_descriptors, knn_matches, 2);
+
+    // imgIdx is the position of the object inside the combined index, trainIdx is already relative to the object
+    for (const auto &m : knn_matches) {
+        if (m.size() == 2 && m[0].distance < matchRatio * m[1].distance)
+            matches[indexObjects[m[0].imgIdx]].push_back(m[0]);
+    }
+}
+
+bool ObjectModelRegistry::locate(int id, const vector<KeyPoint> &frame_keypoints, const vector<DMatch> &matches,
+                                 double ransac_reproject_error, vector<Point2f> &outline, vector<Point2f> &inliers) const {
+    const ObjectModel &model = models[id];
+    outline.clear();
+    inliers.clear();
+
+    if (matches.size() < 4)
+        return false;
+
+    vector<Point2f> h_src, h_dst;
+    for (const auto &m : matches) {
+        h_src.push_back(model.keypoints[m.trainIdx].pt);
+        h_dst.push_back(frame_keypoints[m.queryIdx].pt);
+    }
+
+    vector<uint8_t> mask;
+    Mat H;
+    {
+        TRACE_SCOPE("lab6.locate_homography");
+        H = findHomography(h_src, h_dst, RANSAC, ransac_reproject_error, mask);
+    }
+    if (H.empty())
+        return false;
+
+    //adjust destination points considered into the frame
+    for (int j = 0; j < h_dst.size(); j++) {
+        if (mask[j])
+            inliers.push_back(h_dst[j]);
+    }
+
+    outline.push_back(Point2f(0, 0));
+    outline.push_back(Point2f(model.size.width, 0));
+    outline.push_back(Point2f(0, model.size.height));
+    outline.push_back(Point2f(model.size.width, model.size.height));
+    perspectiveTransform(outline, outline, H);
+
+    return true;
+}
+
+bool ObjectModelRegistry::save(const string &path) const {
+    FileStorage fs(path, FileStorage::WRITE);
+    if (!fs.isOpened())
+        return false;
+
+    fs << "objects" << "[";
+    for (const auto &model : models) {
+        fs << "{";
+        fs << "name" << model.name;
+        fs << "size" << model.size;
+        write(fs, "keypoints", model.keypoints);
+        fs << "descriptors" << model.descriptors;
+        fs << "}";
+    }
+    fs << "]";
+
+    return true;
+}
+
+bool ObjectModelRegistry::load(const string &path) {
+    FileStorage fs(path, FileStorage::READ);
+    if (!fs.isOpened())
+        return false;
+
+    models.clear();
+    FileNode objects = fs["objects"];
+    for (auto it = objects.begin(); it != objects.end(); ++it) {
+        const FileNode &node = *it;
+
+        ObjectModel model;
+        model.name = (string) node["name"];
+        node["size"] >> model.size;
+        read(node["keypoints"], model.keypoints);
+        node["descriptors"] >> model.descriptors;
+        train(model);
+
+        models.push_back(model);
+    }
+
+    return true;
+}
+
+int ObjectModelRegistry::size() const {
+    return models.size();
+}
+
+const ObjectModel& ObjectModelRegistry::operator[](int id) const {
+    return models[id];
+}
+
+void ObjectModelRegistry::train(ObjectModel &model) {
+    model.matcher = BFMatcher::create(NORM_L2);
+    if (!model.descriptors.empty()) {
+        model.matcher->add(vector<Mat>({ model.descriptors }));
+        model.matcher->train();
+    }
+}
@@ -0,0 +1,509 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <opencv2/imgproc.hpp>
+#include "vision_core/image_io.h"
+#include "vision_core/panoramic_image.h"
+#include "vision_core/projection.h"
+#include "vision_core/trace.h"
+
+using namespace cv;
+using namespace std;
+
+const vector<Mat>& PanoramicImage::alignmentImages() const {
+    return align_scale < 1 ? small_images : images;
+}
+
+float PanoramicImage::refineTranslation(int i, float dx) const {
+    TRACE_SCOPE("lab5.refine_translation");
+    const int patch_max = 256;
+    const Mat &a = images[i], &b = images[i+1];
+
+    int overlap_start = max(0, (int) ceil(-dx)), overlap_end = min(a.cols, (int) floor(a.cols - dx));
+    int pw = min(patch_max, overlap_end - overlap_start - 2 * refine_window);
+    int ph = min(patch_max, a.rows - 2 * refine_window);
+    if (pw < 16 || ph < 16)
+        return dx;
+
+    Rect patch((overlap_start + overlap_end - pw) / 2, (a.rows - ph) / 2, pw, ph);
+    Rect search = Rect(patch.x + cvRound(dx) - refine_window, patch.y - refine_window,
+                       pw + 2 * refine_window, ph + 2 * refine_window) & Rect(Point(0, 0), b.size());
+    if (search.width < pw || search.height < ph)
+        return dx;
+
+    Mat patch_gray, search_gray, scores;
+    cvtColor(a(patch), patch_gray, COLOR_BGR2GRAY);
+    cvtColor(b(search), search_gray, COLOR_BGR2GRAY);
+    matchTemplate(search_gray, patch_gray, scores, TM_CCOEFF_NORMED);
+
+    double best;
+    Point best_loc;
+    minMaxLoc(scores, nullptr, &best, nullptr, &best_loc);
+    // flat or repetitive overlap: the low resolution estimate is more reliable
+    if (best < 0.5)
+        return dx;
+
+    return (float) (search.x + best_loc.x - patch.x);
+}
+
+pair<vector<Range>, vector<Range>> PanoramicImage::overlapFromTranslation(float dx, int cols, int margin) {
+    Range first(max(0, (int) floor(-dx) - margin), min(cols, (int) ceil(cols - dx) + margin));
+    Range second(max(0, (int) floor(dx) - margin), min(cols, (int) ceil(cols + dx) + margin));
+    if (first.start >= first.end || second.start >= second.end)
+        first = second = Range(0, cols);
+    return make_pair(vector<Range>{ first }, vector<Range>{ second });
+}
+
+void PanoramicImage::alignByPhaseCorrelation() {
+    TRACE_SCOPE("lab5.phase_align");
+    const vector<Mat> &aligned = alignmentImages();
+    phase_translations.assign(aligned.size() > 1 ? aligned.size() - 1 : 0, 0);
+    phase_aligned.assign(phase_translations.size(), false);
+    phase_responses.assign(phase_translations.size(), 0);
+
+    vector<Mat> gray(aligned.size());
+    for (int i = 0; i < (int) aligned.size(); i++)
+        cvtColor(aligned[i], gray[i], COLOR_BGR2GRAY);
+
+    for (int i = 0; i + 1 < (int) aligned.size(); i++) {
+        vector<Range> all = { Range(0, aligned[i].cols) };
+        const vector<Range> &first = overlap_columns.empty() ? all : overlap_columns[i].first;
+        const vector<Range> &second = overlap_columns.empty() ? all : overlap_columns[i].second;
+
+        PhaseCorrelation best;
+        float best_dx = 0;
+        for (const auto &ra : first) {
+            for (const auto &rb : second) {
+                PhaseCorrelation c = phase_correlator.correlate(gray[i].colRange(ra), gray[i+1].colRange(rb));
+                if (c.response > best.response) {
+                    best = c;
+                    // shift between the strips back to the shift between the images
+                    best_dx = (float) c.shift.x + rb.start - ra.start;
+                }
+            }
+        }
+
+        phase_translations[i] = best_dx;
+        phase_responses[i] = best.response;
+        phase_aligned[i] = best.response >= min_phase_response;
+        TRACE_COUNT("lab5.phase_aligned", phase_aligned[i] ? 1 : 0);
+    }
+}
+
+void PanoramicImage::smallFeatures(const Mat &image, double scale, int max_features, vector<KeyPoint> &kp, Mat &ds) {
+    Mat small;
+    resize(image, small, Size(), scale, scale, INTER_AREA);
+    extractor->detect(small, kp);
+    KeyPointsFilter::retainBest(kp, max_features);
+    extractor->compute(small, kp, ds);
+}
+
+TranslationEstimate PanoramicImage::smallTranslation(const vector<KeyPoint> &kp1, const Mat &ds1,
+                                                     const vector<KeyPoint> &kp2, const Mat &ds2) {
+    vector<DMatch> small_matches;
+    if (!ds1.empty() && !ds2.empty())
+        matcher.match(ds1, ds2, small_matches);
+
+    vector<Point2f> src, dst;
+    for (const auto &m : small_matches) {
+        src.push_back(kp1[m.queryIdx].pt);
+        dst.push_back(kp2[m.trainIdx].pt);
+    }
+    return translation_estimator.estimate(src, dst);
+}
+
+vector<Range> PanoramicImage::searchedColumns(int i) const {
+    const int cols = alignmentImages()[i].cols;
+    if (overlap_columns.empty())
+        return { Range(0, cols) };
+
+    vector<Range> strips;
+    if (i > 0)
+        strips.insert(strips.end(), overlap_columns[i-1].second.begin(), overlap_columns[i-1].second.end());
+    if (i < (int) overlap_columns.size())
+        strips.insert(strips.end(), overlap_columns[i].first.begin(), overlap_columns[i].first.end());
+    sort(strips.begin(), strips.end(), [](const Range &a, const Range &b) { return a.start < b.start; });
+
+    vector<Range> merged;
+    for (const auto &r : strips) {
+        if (!merged.empty() && r.start <= merged.back().end)
+            merged.back().end = max(merged.back().end, r.end);
+        else if (r.size() > 0)
+            merged.push_back(r);
+    }
+    return merged;
+}
+
+bool PanoramicImage::inColumns(const KeyPoint &kp, const vector<Range> &columns) {
+    for (const auto &c : columns) {
+        if (kp.pt.x >= c.start && kp.pt.x < c.end)
+            return true;
+    }
+    return false;
+}
+
+PanoramicImage::PanoramicImage(string images_folder_path, int FOV) {
+    // pictures are decoded and projected in parallel, the projection runs on the decoding threads
+    ImageLoadOptions options;
+    options.transform = [FOV](Mat &img) { img = ::cylindricalProj(img, FOV / 2); };
+    loadImages(images_folder_path + "/*.*", images, nullptr, options);
+}
+
+PanoramicImage::PanoramicImage(vector<Mat> projected_images) : images(std::move(projected_images)) {}
+
+PanoramicImage& PanoramicImage::alignAtScale(double scale, int refine_window) {
+    align_scale = min(1.0, scale);
+    this->refine_window = refine_window;
+
+    small_images.clear();
+    if (align_scale < 1) {
+        for (const auto &img : images) {
+            Mat small;
+            resize(img, small, Size(), align_scale, align_scale, INTER_AREA);
+            small_images.push_back(small);
+        }
+    }
+    return *this;
+}
+
+PanoramicImage& PanoramicImage::limitKeypoints(int max_keypoints) {
+    this->max_keypoints = max_keypoints;
+    return *this;
+}
+
+PanoramicImage& PanoramicImage::usePhaseCorrelation(double min_response) {
+    min_phase_response = min_response;
+    return *this;
+}
+
+PanoramicImage& PanoramicImage::useOverlapPrior(double overlap, double margin, double scale) {
+    TRACE_SCOPE("lab5.overlap_prior");
+    const vector<Mat> &aligned = alignmentImages();
+    overlap_columns.clear();
+    if (aligned.size() < 2)
+        return *this;
+
+    // sign of the translation of the sweep, 0 if unknown
+    int direction = 0;
+    vector<KeyPoint> kp1, kp2;
+    Mat ds1, ds2;
+    smallFeatures(aligned[0], scale, 1000, kp1, ds1);
+    smallFeatures(aligned[1], scale, 1000, kp2, ds2);
+    TranslationEstimate estimate = smallTranslation(kp1, ds1, kp2, ds2);
+    if (estimate.valid && estimate.translation.x != 0)
+        direction = estimate.translation.x < 0 ? -1 : 1;
+
+    for (int i = 0; i + 1 < (int) aligned.size(); i++) {
+        int cols = aligned[i].cols;
+        int strip = min(cols, (int) ceil((overlap + margin) * cols));
+        Range left(0, strip), right(cols - strip, cols);
+        if (direction < 0)      // the next image continues on the right: right side of i, left side of i+1
+            overlap_columns.emplace_back(vector<Range>{ right }, vector<Range>{ left });
+        else if (direction > 0)
+            overlap_columns.emplace_back(vector<Range>{ left }, vector<Range>{ right });
+        else
+            overlap_columns.emplace_back(vector<Range>{ left, right }, vector<Range>{ left, right });
+    }
+    return *this;
+}
+
+PanoramicImage& PanoramicImage::estimateOverlap(double scale, double margin) {
+    TRACE_SCOPE("lab5.estimate_overlap");
+    const vector<Mat> &aligned = alignmentImages();
+    overlap_columns.clear();
+
+    vector<vector<KeyPoint>> small_kp(aligned.size());
+    vector<Mat> small_ds(aligned.size());
+    for (int i = 0; i < (int) aligned.size(); i++)
+        smallFeatures(aligned[i], scale, 1000, small_kp[i], small_ds[i]);
+
+    for (int i = 0; i + 1 < (int) aligned.size(); i++) {
+        int cols = aligned[i].cols;
+        TranslationEstimate estimate = smallTranslation(small_kp[i], small_ds[i], small_kp[i+1], small_ds[i+1]);
+        if (!estimate.valid) {
+            vector<Range> all = { Range(0, cols) };
+            overlap_columns.emplace_back(all, all);
+            continue;
+        }
+
+        overlap_columns.push_back(overlapFromTranslation(estimate.translation.x / scale, cols, (int) ceil(margin * cols)));
+    }
+
+    return *this;
+}
+
+PanoramicImage& PanoramicImage::findKeypoints() {
+    keypoints = vector<vector<KeyPoint>>();
+    descriptors = vector<Mat>();
+
+    phase_aligned.clear();
+    phase_translations.clear();
+    if (min_phase_response > 0)
+        alignByPhaseCorrelation();
+
+    vector<KeyPoint> kp;
+    Mat ds;
+
+    const vector<Mat> &aligned = alignmentImages();
+    for (int i = 0; i < (int) aligned.size(); i++) {
+        const Mat &image = aligned[i];
+
+        // no features needed when both pairs of the image are aligned by phase correlation
+        if (!phase_aligned.empty() && (i == 0 || phase_aligned[i-1]) && (i + 1 == (int) aligned.size() || phase_aligned[i])) {
+            keypoints.emplace_back();
+            descriptors.emplace_back();
+            continue;
+        }
+
+        const vector<Range> strips = searchedColumns(i);
+
+        // keypoints of each strip, in the coordinates of the strip; class_id tells the strip of each one
+        // while the strongest of the whole image are kept
+        vector<KeyPoint> found;
+        {
+            TRACE_SCOPE("lab5.sift_detect");
+            for (int s = 0; s < (int) strips.size(); s++) {
+                extractor->detect(image.colRange(strips[s]), kp);
+                for (auto &k : kp)
+                    k.class_id = s;
+                found.insert(found.end(), kp.begin(), kp.end());
+            }
+        }
+        if (max_keypoints > 0)
+            KeyPointsFilter::retainBest(found, max_keypoints);
+
+        vector<KeyPoint> image_kp;
+        vector<Mat> image_ds;
+        {
+            TRACE_SCOPE("lab5.sift_compute");
+            for (int s = 0; s < (int) strips.size(); s++) {
+                kp.clear();
+                for (const auto &k : found) {
+                    if (k.class_id == s)
+                        kp.push_back(k);
+                }
+                if (kp.empty())
+                    continue;
+
+                extractor->compute(image.colRange(strips[s]), kp, ds);
+                // back to the coordinates of the image
+                for (auto &k : kp) {
+                    k.pt.x += strips[s].start;
+                    k.class_id = -1;
+                }
+                image_kp.insert(image_kp.end(), kp.begin(), kp.end());
+                image_ds.push_back(ds.clone());
+            }
+        }
+        kp = image_kp;
+        if (image_ds.empty())
+            ds = Mat();
+        else
+            vconcat(image_ds, ds);
+        TRACE_COUNT("lab5.keypoints", kp.size());
+        keypoints.push_back(kp);
+        descriptors.push_back(ds.clone());
+
+        /*
+        // DEBUG - show keypoints
+        Mat temp;
+        drawKeypoints(image, kp, temp);
+
+        namedWindow("Keypoints", WINDOW_NORMAL);
+        imshow("Keypoints", temp);
+
+        waitKey(0);
+        destroyAllWindows();
+         */
+    }
+
+    return *this;
+}
+
+PanoramicImage& PanoramicImage::findMatches() {
+    matches = vector<vector<DMatch>>();
+
+    vector<DMatch> curr_matches;
+
+    for (int i = 0; i < (int) keypoints.size() - 1; i++) {
+        if (!phase_aligned.empty() && phase_aligned[i]) {
+            matches.emplace_back();
+            continue;
+        }
+
+        // indices of the keypoints taking part in this pair
+        vector<int> idx1, idx2;
+        for (int j = 0; j < (int) keypoints[i].size(); j++) {
+            if (overlap_columns.empty() || inColumns(keypoints[i][j], overlap_columns[i].first))
+                idx1.push_back(j);
+        }
+        for (int j = 0; j < (int) keypoints[i+1].size(); j++) {
+            if (overlap_columns.empty() || inColumns(keypoints[i+1][j], overlap_columns[i].second))
+                idx2.push_back(j);
+        }
+
+        Mat ds1(idx1.size(), descriptors[i].cols, descriptors[i].type());
+        Mat ds2(idx2.size(), descriptors[i+1].cols, descriptors[i+1].type());
+        for (int j = 0; j < (int) idx1.size(); j++)
+            descriptors[i].row(idx1[j]).copyTo(ds1.row(j));
+        for (int j = 0; j < (int) idx2.size(); j++)
+            descriptors[i+1].row(idx2[j]).copyTo(ds2.row(j));
+
+        curr_matches.clear();
+        if (!ds1.empty() && !ds2.empty()) {
+            TRACE_SCOPE("lab5.bf_match");
+            matcher.match(ds1, ds2, curr_matches);
+        }
+
+        // back to the indices of keypoints[i] and keypoints[i+1]
+        for (auto &m : curr_matches) {
+            m.queryIdx = idx1[m.queryIdx];
+            m.trainIdx = idx2[m.trainIdx];
+        }
+        matches.push_back(curr_matches);
+
+        /*
+        // DEBUG - show matches
+        Mat matchImg;
+        drawMatches(alignmentImages()[i], keypoints[i], alignmentImages()[i+1], keypoints[i+1], curr_matches, matchImg);
+        namedWindow("matches");
+        imshow("matches", matchImg);
+        waitKey(0);
+        destroyAllWindows();
+         */
+
+    }
+
+    return *this;
+}
+
+PanoramicImage& PanoramicImage::refineAndComputeTranslations(float match_filter_ratio) {
+    x_translations = vector<int>();
+    translation_confidence = vector<double>();
+    reliable_translations = vector<bool>();
+
+    for (int i = 0; i < (int) matches.size(); i++) {
+
+        if (!phase_aligned.empty() && phase_aligned[i]) {
+            translation_confidence.push_back(min(1.0, phase_responses[i]));
+            reliable_translations.push_back(true);
+
+            float dx = phase_translations[i] / align_scale;
+            if (refine_window > 0)
+                dx = refineTranslation(i, dx);
+            x_translations.push_back(dx);
+            continue;
+        }
+
+        // Find min match distance and use it to refine matches
+        float min_match_dist = INFINITY;
+        for (const auto& match : matches[i]) {
+            if (match.distance < min_match_dist)
+                min_match_dist = match.distance;
+        }
+
+        // Remove matches that don't satisfy the criteria
+        auto criteria =[&](DMatch m) { return m.distance > min_match_dist * match_filter_ratio; };
+        matches[i].erase(remove_if(matches[i].begin(), matches[i].end(), criteria), matches[i].end());
+
+        /*
+        // DEBUG - show matches
+        Mat matchImg;
+        drawMatches(alignmentImages()[i], keypoints[i], alignmentImages()[i+1], keypoints[i+1], matches[i], matchImg);
+        namedWindow("matches");
+        imshow("matches", matchImg);
+        waitKey(0);
+        destroyAllWindows();
+        */
+
+        // Robust translation of the remaining matches, the only model the composition uses
+        vector<Point2f> h_src;
+        vector<Point2f> h_dst;
+
+        for (const auto &match : matches[i]) {
+            h_src.push_back(keypoints[i][match.queryIdx].pt);
+            h_dst.push_back(keypoints[i+1][match.trainIdx].pt);
+        }
+
+        TranslationEstimate estimate = translation_estimator.estimate(h_src, h_dst);
+        translation_confidence.push_back(estimate.confidence);
+        reliable_translations.push_back(estimate.valid);
+        if (!estimate.valid)
+            cerr << "Pictures " << i << " and " << i + 1 << ": unreliable translation (" << estimate.inlierCount
+                 << " inliers, confidence " << estimate.confidence << ")" << endl;
+
+        // Append x translation, in full resolution pixels
+        float dx = estimate.translation.x / align_scale;
+        if (refine_window > 0 && estimate.valid)
+            dx = refineTranslation(i, dx);
+        x_translations.push_back(dx);
+    }
+
+    // Steps of a sweep are close to each other: unreliable pairs take the median of the reliable ones
+    vector<int> reliable;
+    for (int i = 0; i < (int) x_translations.size(); i++) {
+        if (reliable_translations[i])
+            reliable.push_back(x_translations[i]);
+    }
+    if (!reliable.empty()) {
+        nth_element(reliable.begin(), reliable.begin() + reliable.size() / 2, reliable.end());
+        for (int i = 0; i < (int) x_translations.size(); i++) {
+            if (!reliable_translations[i])
+                x_translations[i] = reliable[reliable.size() / 2];
+        }
+    }
+
+    return *this;
+}
+
+int PanoramicImage::panoramicWidth() const {
+    int panoramic_width = images[0].cols;
+    for (auto &dx : x_translations)
+        panoramic_width += abs(dx);
+    return panoramic_width;
+}
+
+template <typename Writer>
+void PanoramicImage::composeStrips(Writer write) const {
+    int img_rows = images[0].rows;
+    int img_cols = images[0].cols;
+    int panoramic_width = panoramicWidth();
+
+    // Init with the first image, then concatenate portions of consecutive images
+    write(images[0], Point(0, 0));
+
+    // Start composing from right if the translations are positive - ie pictures taken with counterclockwise direction
+    int curr_x = x_translations[0] > 0 ? panoramic_width - img_cols : img_cols;
+
+    for (int i = 0; i < (int) x_translations.size(); i++) {
+        // Portion of image to copy depends on the direction on which pictures are taken
+        Rect curr_img_roi;
+        if (x_translations[i] < 0) // If clockwise direction: right portion of the current image, otherwise left portion
+            curr_img_roi = Rect(img_cols + x_translations[i], 0, -x_translations[i], img_rows);
+        else
+            curr_img_roi = Rect(0, 0, x_translations[i], img_rows);
+
+        write(images[i+1](curr_img_roi), Point(curr_x, 0));
+
+        curr_x -= x_translations[i];
+    }
+}
+
+Mat PanoramicImage::composePanoramicImage() {
+    TRACE_SCOPE("lab5.compose");
+    Mat panoramic = Mat(images[0].rows, panoramicWidth(), images[0].type());
+    composeStrips([&](const Mat &strip, Point at) {
+        strip.copyTo(panoramic(Rect(at, strip.size())));
+    });
+    return panoramic;
+}
+
+bool PanoramicImage::composePanoramicImage(TiledCanvas &canvas, const string &directory) {
+    TRACE_SCOPE("lab5.compose_canvas");
+    if (!canvas.create(Size(panoramicWidth(), images[0].rows), images[0].type(), 256, directory))
+        return false;
+    composeStrips([&](const Mat &strip, Point at) {
+        canvas.write(strip, at);
+    });
+    return true;
+}
@@ -0,0 +1,101 @@
+#include <cfloat>
+#include <cmath>
+#include <opencv2/imgproc.hpp>
+#include "vision_core/phase_correlation.h"
+#include "vision_core/trace.h"
+
+using namespace cv;
+using namespace std;
+
+// half size of the neighbourhood of the peak giving the sub-pixel centroid and the response
+static const int PEAK_RADIUS = 2;
+
+PhaseCorrelator::Plan& PhaseCorrelator::plan(Size size) {
+    auto key = make_pair(size.width, size.height);
+    auto found = plans.find(key);
+    if (found != plans.end())
+        return found->second;
+
+    TRACE_SCOPE("core.phase_correlation_plan");
+    Plan &p = plans[key];
+    createHanningWindow(p.window, size, CV_32F);
+
+    Size padded(getOptimalDFTSize(2 * size.width), getOptimalDFTSize(size.height + size.height / 4));
+    p.padded_a = Mat::zeros(padded, CV_32F);
+    p.padded_b = Mat::zeros(padded, CV_32F);
+    return p;
+}
+
+void PhaseCorrelator::prepare(const Mat &src, const Plan &p, Mat &padded) {
+    if (src.channels() == 3)
+        cvtColor(src, gray, COLOR_BGR2GRAY);
+    else
+        gray = src;
+
+    // zero mean before the window, so that the zero padding doesn't add an edge
+    Mat roi = padded(Rect(Point(0, 0), p.window.size()));
+    gray.convertTo(roi, CV_32F);
+    subtract(roi, mean(roi), roi);
+    multiply(roi, p.window, roi);
+}
+
+PhaseCorrelation PhaseCorrelator::correlate(const Mat &a, const Mat &b) {
+    TRACE_SCOPE("core.phase_correlate");
+    CV_Assert(a.type() == b.type() && (a.channels() == 1 || a.channels() == 3));
+
+    PhaseCorrelation result;
+    Size size(min(a.cols, b.cols), min(a.rows, b.rows));
+    if (size.width < 2 || size.height < 2)
+        return result;
+
+    Plan &p = plan(size);
+    prepare(a(Rect(Point(0, 0), size)), p, p.padded_a);
+    prepare(b(Rect(Point(0, 0), size)), p, p.padded_b);
+
+    dft(p.padded_a, p.spectrum_a, DFT_COMPLEX_OUTPUT);
+    dft(p.padded_b, p.spectrum_b, DFT_COMPLEX_OUTPUT);
+
+    // B * conj(A) / |B * conj(A)|: its inverse is a peak at the shift of b with respect to a
+    mulSpectrums(p.spectrum_b, p.spectrum_a, p.cross, 0, true);
+    for (int y = 0; y < p.cross.rows; y++) {
+        Vec2f *c = p.cross.ptr<Vec2f>(y);
+        for (int x = 0; x < p.cross.cols; x++) {
+            float magnitude = sqrt(c[x][0] * c[x][0] + c[x][1] * c[x][1]);
+            c[x] = magnitude > FLT_EPSILON ? c[x] / magnitude : Vec2f(0, 0);
+        }
+    }
+    idft(p.cross, p.correlation, DFT_SCALE | DFT_REAL_OUTPUT);
+
+    Point peak;
+    minMaxLoc(p.correlation, nullptr, nullptr, nullptr, &peak);
+
+    // centroid and energy of the neighbourhood of the peak, which wraps around the borders
+    const int w = p.correlation.cols, h = p.correlation.rows;
+    double sum = 0, sx = 0, sy = 0;
+    for (int dy = -PEAK_RADIUS; dy <= PEAK_RADIUS; dy++) {
+        const float *row = p.correlation.ptr<float>((peak.y + dy + h) % h);
+        for (int dx = -PEAK_RADIUS; dx <= PEAK_RADIUS; dx++) {
+            float v = row[(peak.x + dx + w) % w];
+            if (v <= 0)
+                continue;
+            sum += v;
+            sx += v * dx;
+            sy += v * dy;
+        }
+    }
+
+    // peaks past the middle are negative shifts
+    double x = peak.x + (sum > 0 ? sx / sum : 0);
+    double y = peak.y + (sum > 0 ? sy / sum : 0);
+    result.shift = Point2d(x > w / 2 ? x - w : x, y > h / 2 ? y - h : y);
+    result.response = sum;
+    return result;
+}
+
+size_t PhaseCorrelator::cachedSizes() const {
+    return plans.size();
+}
+
+void PhaseCorrelator::clear() {
+    plans.clear();
+}
@@ -0,0 +1,74 @@
+#include <cmath>
+#include <opencv2/imgproc.hpp>
+#include "vision_core/pixel_kernels.h"
+#include "vision_core/projection.h"
+#include "vision_core/trace.h"
+
+using namespace cv;
+
+void CylindricalProjector::buildMap(Size size, double angle) {
+    map.create(size, CV_32FC2);
+
+    double alpha(angle / 180 * CV_PI);
+    double d((size.width / 2.0) / tan(alpha));
+    double r(d / cos(alpha));
+    double d_by_r(d / r);
+    int half_height_image(size.height / 2);
+    int half_width_image(size.width / 2);
+
+    // identity everywhere, only the pixels inside the projection are moved
+    for (int row = 0; row < size.height; row++) {
+        Vec2f *m = map.ptr<Vec2f>(row);
+        for (int col = 0; col < size.width; col++)
+            m[col] = Vec2f((float) col, (float) row);
+    }
+
+    // integer source coordinates, so that INTER_NEAREST doesn't round them again
+    for (int x = - half_width_image + 1; x < half_width_image; ++x) {
+        double x1(d * tan(x / r));
+        double cos_x = cos(x / r);
+
+        for (int y = - half_height_image + 1; y < half_height_image; ++y) {
+            double y1(y * d_by_r / cos_x);
+
+            if (x1 < half_width_image && x1 > - half_width_image + 1 &&
+                y1 < half_height_image && y1 > - half_height_image + 1) {
+                int src_row = std::min((int) round(y1 + half_height_image), size.height - 1);
+                int src_col = std::min((int) round(x1 + half_width_image), size.width - 1);
+                map.at<Vec2f>(y + half_height_image, x + half_width_image) = Vec2f((float) src_col, (float) src_row);
+            }
+        }
+    }
+
+    offsets.create(size, CV_32SC1);
+    for (int row = 0; row < size.height; row++) {
+        const Vec2f *m = map.ptr<Vec2f>(row);
+        int32_t *o = offsets.ptr<int32_t>(row);
+        for (int col = 0; col < size.width; col++)
+            o[col] = ((int) m[col][1] * size.width + (int) m[col][0]) * 3;
+    }
+
+    mapSize = size;
+    mapAngle = angle;
+}
+
+void CylindricalProjector::project(const Mat &src, Mat &dst, double angle) {
+    TRACE_SCOPE("core.cylindrical_proj");
+
+    if (src.size() != mapSize || angle != mapAngle)
+        buildMap(src.size(), angle);
+
+    CV_Assert(src.data != dst.data);
+    if (src.type() == CV_8UC3 && src.isContinuous())
+        gatherPixels(src, offsets, dst);
+    else
+        remap(src, dst, map, noArray(), INTER_NEAREST, BORDER_REPLICATE);
+}
+
+Mat cylindricalProj(const Mat &image, double angle) {
+    thread_local CylindricalProjector projector;
+
+    Mat result;
+    projector.project(image, result, angle);
+    return result;
+}
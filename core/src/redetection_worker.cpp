@@ -0,0 +1,88 @@
+#include <opencv2/imgproc.hpp>
+#include "vision_core/features.h"
+#include "vision_core/redetection_worker.h"
+#include "vision_core/trace.h"
+
+using namespace std;
+using namespace cv;
+
+RedetectionWorker::RedetectionWorker(const ObjectModelRegistry &models, double ransac_reproject_error)
+    : models(models), ransacReprojectError(ransac_reproject_error) {
+    detector = createSiftDetector();
+    worker = thread(&RedetectionWorker::loop, this);
+}
+
+RedetectionWorker::~RedetectionWorker() {
+    {
+        lock_guard<mutex> lock(state_mutex);
+        stop = true;
+    }
+    has_work.notify_one();
+    worker.join();
+}
+
+bool RedetectionWorker::request(const Mat &frame, int frame_index, const vector<int> &objects) {
+    {
+        lock_guard<mutex> lock(state_mutex);
+        if (busy)
+            return false;
+
+        // the worker is idle, so it doesn't touch the frame buffer: it is reused across requests
+        frame.copyTo(this->frame);
+        this->frameIndex = frame_index;
+        this->objects = objects;
+        busy = true;
+    }
+    has_work.notify_one();
+    return true;
+}
+
+bool RedetectionWorker::collect(vector<Redetection> &results) {
+    lock_guard<mutex> lock(state_mutex);
+    for (auto &detection : completed)
+        results.push_back(move(detection));
+    completed.clear();
+
+    return !busy;
+}
+
+void RedetectionWorker::loop() {
+    vector<KeyPoint> keypoints;
+    Mat descriptors;
+    vector<vector<DMatch>> matches;
+
+    while (true) {
+        {
+            unique_lock<mutex> lock(state_mutex);
+            has_work.wait(lock, [this] { return stop || busy; });
+            if (stop)
+                return;
+        }
+
+        // frame and objects are only written by request() while the worker is idle
+        TRACE_SCOPE("lab6.redetection");
+        Mat gray;
+        cvtColor(frame, gray, COLOR_BGR2GRAY);
+        {
+            TRACE_SCOPE("lab6.sift_detect_compute");
+            detector->detectAndCompute(frame, noArray(), keypoints, descriptors);
+        }
+        models.matchAll(descriptors, matches);
+
+        vector<Redetection> found;
+        for (int obj : objects) {
+            Redetection detection;
+            detection.object = obj;
+            detection.frameIndex = frameIndex;
+            detection.gray = gray;
+
+            if (models.locate(obj, keypoints, matches[obj], ransacReprojectError, detection.outline, detection.points))
+                found.push_back(move(detection));
+        }
+
+        lock_guard<mutex> lock(state_mutex);
+        for (auto &detection : found)
+            completed.push_back(move(detection));
+        busy = false;
+    }
+}
@@ -0,0 +1,74 @@
+#include <opencv2/imgproc.hpp>
+#include "vision_core/region_stats.h"
+#include "vision_core/trace.h"
+
+using namespace cv;
+using namespace std;
+
+RegionStats::RegionStats(const Mat &image) {
+    build(image);
+}
+
+void RegionStats::build(const Mat &image) {
+    TRACE_SCOPE("core.region_stats_build");
+    CV_Assert(image.channels() <= 4);
+
+    // doubles: 32-bit sums overflow on 8-bit images of more than 16M pixels, and the squares much earlier
+    integral(image, sum, sqsum, CV_64F, CV_64F);
+    channels = image.channels();
+    size = image.size();
+}
+
+bool RegionStats::empty() const {
+    return channels == 0;
+}
+
+Rect RegionStats::clip(const Rect &rect) const {
+    return rect & Rect(Point(0, 0), size);
+}
+
+Scalar RegionStats::rectSum(const Mat &integral, const Rect &rect) const {
+    const double *top = integral.ptr<double>(rect.y);
+    const double *bottom = integral.ptr<double>(rect.y + rect.height);
+    const int left = rect.x * channels, right = (rect.x + rect.width) * channels;
+
+    Scalar s;
+    for (int c = 0; c < channels; c++)
+        s[c] = bottom[right + c] - bottom[left + c] - top[right + c] + top[left + c];
+    return s;
+}
+
+int RegionStats::query(const Rect &rect, Scalar &mean, Scalar &variance) const {
+    Rect r = clip(rect);
+    mean = Scalar();
+    variance = Scalar();
+
+    const int area = r.area();
+    if (area <= 0)
+        return 0;
+
+    Scalar s = rectSum(sum, r), sq = rectSum(sqsum, r);
+    for (int c = 0; c < channels; c++) {
+        mean[c] = s[c] / area;
+        // rounding can make it slightly negative on uniform regions
+        variance[c] = max(0.0, sq[c] / area - mean[c] * mean[c]);
+    }
+    return area;
+}
+
+Scalar RegionStats::mean(const Rect &rect) const {
+    Rect r = clip(rect);
+    if (r.area() <= 0)
+        return Scalar();
+
+    Scalar s = rectSum(sum, r);
+    for (int c = 0; c < channels; c++)
+        s[c] /= r.area();
+    return s;
+}
+
+Scalar RegionStats::variance(const Rect &rect) const {
+    Scalar mean, variance;
+    query(rect, mean, variance);
+    return variance;
+}
@@ -0,0 +1,160 @@
+#include <opencv2/imgproc.hpp>
+#include "vision_core/tiff_writer.h"
+#include "vision_core/trace.h"
+
+using namespace cv;
+using namespace std;
+
+// TIFF field types and tags, see the TIFF 6.0 and BigTIFF specifications
+static const uint16_t TIFF_SHORT = 3, TIFF_LONG = 4, TIFF_LONG8 = 16;
+static const uint16_t TAG_IMAGE_WIDTH = 256, TAG_IMAGE_LENGTH = 257, TAG_BITS_PER_SAMPLE = 258,
+        TAG_COMPRESSION = 259, TAG_PHOTOMETRIC = 262, TAG_SAMPLES_PER_PIXEL = 277, TAG_PLANAR_CONFIG = 284,
+        TAG_TILE_WIDTH = 322, TAG_TILE_LENGTH = 323, TAG_TILE_OFFSETS = 324, TAG_TILE_BYTE_COUNTS = 325;
+
+TiledTiffWriter::~TiledTiffWriter() {
+    if (isOpen())
+        close();
+}
+
+void TiledTiffWriter::put(uint64_t value, int bytes) {
+    // TIFF "II": little endian whatever the machine
+    char le[8];
+    for (int i = 0; i < bytes; i++)
+        le[i] = (char) ((value >> (8 * i)) & 0xff);
+    out.write(le, bytes);
+}
+
+void TiledTiffWriter::entry(uint16_t tag, uint16_t fieldType, uint64_t count, uint64_t value) {
+    // values that fit the entry are stored in it, left justified: the same bytes as value in little endian
+    put(tag, 2);
+    put(fieldType, 2);
+    put(count, bigTiff ? 8 : 4);
+    put(value, bigTiff ? 8 : 4);
+}
+
+bool TiledTiffWriter::open(const string &path, Size size, int type, int tileSize) {
+    CV_Assert(type == CV_8UC1 || type == CV_8UC3);
+    CV_Assert(tileSize > 0 && tileSize % 16 == 0);
+
+    if (isOpen())
+        close();
+
+    this->size = size;
+    this->type = type;
+    this->tileSize = tileSize;
+    grid = Size((size.width + tileSize - 1) / tileSize, (size.height + tileSize - 1) / tileSize);
+    offsets.assign((size_t) grid.area(), 0);
+    byteCounts.assign((size_t) grid.area(), 0);
+    buffer.create(tileSize, tileSize, type);
+
+    // pixels, index and header, with room to spare
+    uint64_t estimate = (uint64_t) grid.area() * tileSize * tileSize * CV_ELEM_SIZE(type) + (uint64_t) grid.area() * 16 + 4096;
+    bigTiff = estimate > 0xffffffffULL;
+
+    out.open(path, ios::binary | ios::trunc);
+    if (!out)
+        return false;
+
+    out.write("II", 2);
+    if (bigTiff) {
+        put(43, 2);
+        put(8, 2);
+        put(0, 2);
+        // offset of the IFD, written by close
+        put(0, 8);
+    } else {
+        put(42, 2);
+        put(0, 4);
+    }
+    return (bool) out;
+}
+
+bool TiledTiffWriter::isOpen() const {
+    return out.is_open();
+}
+
+bool TiledTiffWriter::writeTile(int tx, int ty, const Mat &tile) {
+    CV_Assert(isOpen() && tile.type() == type);
+    CV_Assert(tx >= 0 && ty >= 0 && tx < grid.width && ty < grid.height);
+    CV_Assert(tile.cols <= tileSize && tile.rows <= tileSize);
+
+    if (tile.cols < tileSize || tile.rows < tileSize)
+        buffer.setTo(0);
+    Mat inside = buffer(Rect(0, 0, tile.cols, tile.rows));
+    if (type == CV_8UC3)
+        cvtColor(tile, inside, COLOR_BGR2RGB);
+    else
+        tile.copyTo(inside);
+
+    size_t index = (size_t) ty * grid.width + tx;
+    offsets[index] = (uint64_t) out.tellp();
+    byteCounts[index] = buffer.total() * buffer.elemSize();
+    out.write((const char *) buffer.data, (streamsize) byteCounts[index]);
+    return (bool) out;
+}
+
+bool TiledTiffWriter::close() {
+    if (!isOpen())
+        return false;
+    TRACE_SCOPE("core.tiff_index");
+
+    const int channels = CV_MAT_CN(type);
+    const uint64_t tiles = offsets.size();
+    const int offsetBytes = bigTiff ? 8 : 4;
+    const uint16_t offsetType = bigTiff ? TIFF_LONG8 : TIFF_LONG;
+
+    // the IFD and its arrays start on a word boundary
+    if (out.tellp() % 2)
+        put(0, 1);
+
+    // arrays which don't fit in their entry
+    uint64_t offsetsAt = offsets.empty() ? 0 : offsets[0], countsAt = byteCounts.empty() ? 0 : byteCounts[0];
+    if (tiles > 1) {
+        offsetsAt = (uint64_t) out.tellp();
+        for (uint64_t o : offsets)
+            put(o, offsetBytes);
+        countsAt = (uint64_t) out.tellp();
+        for (uint64_t c : byteCounts)
+            put(c, offsetBytes);
+    }
+
+    // 8 bits per sample, three shorts (6 bytes) only fit the entry of BigTIFF
+    uint64_t bitsPerSample = 8;
+    if (channels == 3) {
+        if (bigTiff) {
+            bitsPerSample = 8 | (8ULL << 16) | (8ULL << 32);
+        } else {
+            bitsPerSample = (uint64_t) out.tellp();
+            for (int i = 0; i < 3; i++)
+                put(8, 2);
+            put(0, 2);
+        }
+    }
+
+    uint64_t ifdAt = (uint64_t) out.tellp();
+    const int entries = 11;
+    put(entries, bigTiff ? 8 : 2);
+    entry(TAG_IMAGE_WIDTH, TIFF_LONG, 1, (uint64_t) size.width);
+    entry(TAG_IMAGE_LENGTH, TIFF_LONG, 1, (uint64_t) size.height);
+    entry(TAG_BITS_PER_SAMPLE, TIFF_SHORT, channels, bitsPerSample);
+    // no compression
+    entry(TAG_COMPRESSION, TIFF_SHORT, 1, 1);
+    // RGB or black is zero
+    entry(TAG_PHOTOMETRIC, TIFF_SHORT, 1, channels == 3 ? 2 : 1);
+    entry(TAG_SAMPLES_PER_PIXEL, TIFF_SHORT, 1, (uint64_t) channels);
+    // interleaved channels
+    entry(TAG_PLANAR_CONFIG, TIFF_SHORT, 1, 1);
+    entry(TAG_TILE_WIDTH, TIFF_LONG, 1, (uint64_t) tileSize);
+    entry(TAG_TILE_LENGTH, TIFF_LONG, 1, (uint64_t) tileSize);
+    entry(TAG_TILE_OFFSETS, offsetType, tiles, offsetsAt);
+    entry(TAG_TILE_BYTE_COUNTS, offsetType, tiles, countsAt);
+    // no next IFD
+    put(0, offsetBytes);
+
+    out.seekp(bigTiff ? 8 : 4);
+    put(ifdAt, offsetBytes);
+
+    bool ok = (bool) out;
+    out.close();
+    return ok && !out.fail();
+}
@@ -0,0 +1,201 @@
+#include <algorithm>
+#include <cstdlib>
+#include "vision_core/tiff_writer.h"
+#include "vision_core/tiled_canvas.h"
+#include "vision_core/trace.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+using namespace cv;
+using namespace std;
+
+TiledCanvas::TiledCanvas(Size size, int type, int tileSize, const string &directory) {
+    if (!create(size, type, tileSize, directory))
+        CV_Error(Error::StsError, "can't map a canvas file in " + directory);
+}
+
+TiledCanvas::~TiledCanvas() {
+    release();
+}
+
+bool TiledCanvas::create(Size size, int type, int tileSize, const string &directory) {
+    CV_Assert(size.width > 0 && size.height > 0 && tileSize > 0);
+    release();
+
+    canvasSize = size;
+    canvasType = type;
+    side = tileSize;
+    grid = Size((size.width + side - 1) / side, (size.height + side - 1) / side);
+    tileBytes = (size_t) side * side * CV_ELEM_SIZE(type);
+    bytes = tileBytes * grid.area();
+
+#ifndef _WIN32
+    if (!directory.empty()) {
+        TRACE_SCOPE("core.canvas_map");
+        string path = directory + "/canvas-XXXXXX";
+        fd = mkstemp(&path[0]);
+        if (fd < 0) {
+            release();
+            return false;
+        }
+        // no name: the file goes away with the descriptor, even if the process is killed
+        unlink(path.c_str());
+
+        void *mapped = MAP_FAILED;
+        if (ftruncate(fd, (off_t) bytes) == 0)
+            mapped = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (mapped == MAP_FAILED) {
+            release();
+            return false;
+        }
+        data = (uchar *) mapped;
+        return true;
+    }
+#endif
+
+    memory.assign(bytes, 0);
+    data = memory.data();
+    return true;
+}
+
+void TiledCanvas::release() {
+#ifndef _WIN32
+    if (fd >= 0) {
+        if (data)
+            munmap(data, bytes);
+        ::close(fd);
+        fd = -1;
+    }
+#endif
+    memory.clear();
+    memory.shrink_to_fit();
+    data = nullptr;
+    bytes = 0;
+    canvasSize = Size();
+    grid = Size();
+}
+
+bool TiledCanvas::empty() const {
+    return data == nullptr;
+}
+
+Size TiledCanvas::size() const {
+    return canvasSize;
+}
+
+int TiledCanvas::type() const {
+    return canvasType;
+}
+
+int TiledCanvas::tileSize() const {
+    return side;
+}
+
+Size TiledCanvas::tiles() const {
+    return grid;
+}
+
+Rect TiledCanvas::tileRect(int tx, int ty) const {
+    return Rect(tx * side, ty * side, side, side) & Rect(Point(0, 0), canvasSize);
+}
+
+Mat TiledCanvas::tile(int tx, int ty) {
+    return tileHeader(tx, ty);
+}
+
+Mat TiledCanvas::tileHeader(int tx, int ty) const {
+    CV_Assert(tx >= 0 && ty >= 0 && tx < grid.width && ty < grid.height);
+    Rect r = tileRect(tx, ty);
+    uchar *t = data + ((size_t) ty * grid.width + tx) * tileBytes;
+    // full tile rows, so border tiles keep the step of a whole tile
+    return Mat(r.height, r.width, canvasType, t, (size_t) side * CV_ELEM_SIZE(canvasType));
+}
+
+void TiledCanvas::write(const Mat &src, Point offset) {
+    CV_Assert(src.type() == canvasType);
+    Rect area = Rect(offset, src.size()) & Rect(Point(0, 0), canvasSize);
+    if (area.empty())
+        return;
+
+    for (int ty = area.y / side; ty <= (area.br().y - 1) / side; ty++) {
+        for (int tx = area.x / side; tx <= (area.br().x - 1) / side; tx++) {
+            Rect r = tileRect(tx, ty);
+            Rect part = area & r;
+            Mat dst = tile(tx, ty)(part - r.tl());
+            src(part - offset).copyTo(dst);
+        }
+    }
+}
+
+void TiledCanvas::read(const Rect &rect, Mat &dst) const {
+    Rect area = rect & Rect(Point(0, 0), canvasSize);
+    dst.create(area.size(), canvasType);
+    if (area.empty())
+        return;
+
+    for (int ty = area.y / side; ty <= (area.br().y - 1) / side; ty++) {
+        for (int tx = area.x / side; tx <= (area.br().x - 1) / side; tx++) {
+            Rect r = tileRect(tx, ty);
+            Rect part = area & r;
+            Mat out = dst(part - area.tl());
+            tileHeader(tx, ty)(part - r.tl()).copyTo(out);
+        }
+    }
+}
+
+void TiledCanvas::forEachTile(const function<void(const Rect &, Mat &)> &fn) {
+    for (int ty = 0; ty < grid.height; ty++) {
+        for (int tx = 0; tx < grid.width; tx++) {
+            Mat t = tile(tx, ty);
+            fn(tileRect(tx, ty), t);
+        }
+    }
+}
+
+void TiledCanvas::forEachTile(const function<void(const Rect &, const Mat &)> &fn) const {
+    for (int ty = 0; ty < grid.height; ty++) {
+        for (int tx = 0; tx < grid.width; tx++)
+            fn(tileRect(tx, ty), tileHeader(tx, ty));
+    }
+}
+
+bool TiledCanvas::writeTiff(const string &path) const {
+    TRACE_SCOPE("core.canvas_write_tiff");
+    TiledTiffWriter writer;
+    // the TIFF tiles are the canvas tiles when their size is allowed, otherwise the canvas is read in 256 x 256 parts
+    const bool same_tiles = side % 16 == 0;
+    const int tiff_side = same_tiles ? side : 256;
+    if (!writer.open(path, canvasSize, canvasType, tiff_side))
+        return false;
+
+    bool ok = true;
+    if (same_tiles) {
+        forEachTile([&](const Rect &r, const Mat &t) {
+            ok = ok && writer.writeTile(r.x / side, r.y / side, t);
+        });
+    } else {
+        Mat part;
+        for (int y = 0; ok && y < canvasSize.height; y += tiff_side) {
+            for (int x = 0; ok && x < canvasSize.width; x += tiff_side) {
+                read(Rect(x, y, tiff_side, tiff_side), part);
+                ok = writer.writeTile(x / tiff_side, y / tiff_side, part);
+            }
+        }
+    }
+    return writer.close() && ok;
+}
+
+void equalizeHSV(TiledCanvas &canvas, int channels) {
+    TRACE_SCOPE("core.canvas_equalize_hsv");
+    HSVEqualizer equalizer(channels);
+    canvas.forEachTile([&](const Rect &, Mat &t) {
+        equalizer.accumulate(t);
+    });
+    canvas.forEachTile([&](const Rect &, Mat &t) {
+        equalizer.apply(t, t);
+    });
+}
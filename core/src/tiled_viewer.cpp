@@ -0,0 +1,414 @@
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <sys/stat.h>
+#include <opencv2/core/utils/filesystem.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+#include "vision_core/tiled_viewer.h"
+#include "vision_core/trace.h"
+
+using namespace cv;
+using namespace std;
+
+TiledViewerOptions::TiledViewerOptions() {
+    const char *directory = getenv("CVLAB_TILE_CACHE");
+    if (directory)
+        cacheDirectory = directory;
+}
+
+// file or window name usable as a directory name
+static string sanitize(const string &name) {
+    string result(name);
+    for (char &c : result) {
+        if (!isalnum((unsigned char) c) && c != '-' && c != '.')
+            c = '_';
+    }
+    return result;
+}
+
+// PNG only stores 8 and 16 bit images with 1, 3 or 4 channels
+static bool storableTile(int type) {
+    return (CV_MAT_DEPTH(type) == CV_8U || CV_MAT_DEPTH(type) == CV_16U) && CV_MAT_CN(type) != 2;
+}
+
+void TilePyramid::build(const Mat &image, const TiledViewerOptions &options, const string &name) {
+    TRACE_SCOPE("core.tile_pyramid_build");
+    CV_Assert(!image.empty());
+
+    tileSize = options.tileSize;
+    maxCachedTiles = max(1, options.maxCachedTiles);
+    type = image.type();
+    sizes.clear();
+    memoryLevels.clear();
+    cache.clear();
+    lru.clear();
+
+    directory.clear();
+    if (!options.cacheDirectory.empty() && storableTile(type)) {
+        directory = utils::fs::join(options.cacheDirectory, sanitize(name));
+        utils::fs::createDirectories(directory);
+    }
+
+    // on disk only the level being written and the next one are in memory
+    Mat level = image;
+    while (true) {
+        sizes.push_back(level.size());
+
+        if (directory.empty()) {
+            memoryLevels.push_back(level);
+        } else {
+            int l = (int) sizes.size() - 1;
+            for (int y = 0; y < level.rows; y += tileSize) {
+                for (int x = 0; x < level.cols; x += tileSize) {
+                    Rect r = Rect(x, y, tileSize, tileSize) & Rect(Point(0, 0), level.size());
+                    imwrite(tilePath(l, x / tileSize, y / tileSize), level(r));
+                }
+            }
+        }
+
+        if (level.cols <= tileSize && level.rows <= tileSize)
+            break;
+
+        Mat next;
+        resize(level, next, Size((level.cols + 1) / 2, (level.rows + 1) / 2), 0, 0, INTER_AREA);
+        level = next;
+    }
+
+    if (!directory.empty())
+        writeManifest(name);
+}
+
+bool TilePyramid::open(const string &path, const TiledViewerOptions &options) {
+    string source = path;
+    struct stat info;
+    if (stat(path.c_str(), &info) == 0)
+        source += ":" + to_string((long long) info.st_size) + ":" + to_string((long long) info.st_mtime);
+
+    if (!options.cacheDirectory.empty()) {
+        directory = utils::fs::join(options.cacheDirectory, sanitize(path));
+        tileSize = options.tileSize;
+        maxCachedTiles = max(1, options.maxCachedTiles);
+        if (readManifest(source))
+            return true;
+    }
+
+    Mat image;
+    {
+        TRACE_SCOPE("core.imread");
+        image = imread(path, IMREAD_UNCHANGED);
+    }
+    if (image.empty())
+        return false;
+
+    build(image, options, path);
+    if (!directory.empty())
+        writeManifest(source);
+    return true;
+}
+
+void TilePyramid::writeManifest(const string &source) const {
+    FileStorage fs(utils::fs::join(directory, "pyramid.yml"), FileStorage::WRITE);
+    fs << "source" << source;
+    fs << "tile_size" << tileSize;
+    fs << "type" << type;
+    fs << "sizes" << sizes;
+}
+
+bool TilePyramid::readManifest(const string &source) {
+    string manifest = utils::fs::join(directory, "pyramid.yml");
+    if (!utils::fs::exists(manifest))
+        return false;
+
+    FileStorage fs(manifest, FileStorage::READ);
+    if (!fs.isOpened() || (string) fs["source"] != source || (int) fs["tile_size"] != tileSize)
+        return false;
+
+    vector<Size> stored;
+    fs["sizes"] >> stored;
+    if (stored.empty())
+        return false;
+
+    type = (int) fs["type"];
+    sizes = stored;
+    memoryLevels.clear();
+    cache.clear();
+    lru.clear();
+    return true;
+}
+
+bool TilePyramid::empty() const {
+    return sizes.empty();
+}
+
+Size TilePyramid::size() const {
+    return sizes.empty() ? Size() : sizes[0];
+}
+
+int TilePyramid::levels() const {
+    return (int) sizes.size();
+}
+
+Size TilePyramid::levelSize(int level) const {
+    return sizes[level];
+}
+
+string TilePyramid::tilePath(int level, int tx, int ty) const {
+    return utils::fs::join(directory, "L" + to_string(level) + "_" + to_string(ty) + "_" + to_string(tx) + ".png");
+}
+
+const Mat &TilePyramid::tile(int level, int tx, int ty) {
+    const uint64_t key = ((uint64_t) level << 48) | ((uint64_t) ty << 24) | (uint64_t) tx;
+
+    auto found = cache.find(key);
+    if (found != cache.end()) {
+        lru.splice(lru.begin(), lru, found->second.second);
+        return found->second.first;
+    }
+
+    Mat t;
+    {
+        TRACE_SCOPE("core.tile_read");
+        t = imread(tilePath(level, tx, ty), IMREAD_UNCHANGED);
+    }
+    Rect expected = Rect(tx * tileSize, ty * tileSize, tileSize, tileSize) & Rect(Point(0, 0), sizes[level]);
+    if (t.size() != expected.size() || t.type() != type)
+        t = Mat::zeros(expected.size(), type);
+
+    while ((int) cache.size() >= maxCachedTiles) {
+        cache.erase(lru.back());
+        lru.pop_back();
+    }
+    lru.push_front(key);
+    return cache.emplace(key, make_pair(t, lru.begin())).first->second.first;
+}
+
+void TilePyramid::read(int level, const Rect &rect, Mat &dst) {
+    dst.create(rect.size(), type);
+    if (rect.area() <= 0)
+        return;
+
+    if (directory.empty()) {
+        memoryLevels[level](rect).copyTo(dst);
+        return;
+    }
+
+    for (int ty = rect.y / tileSize; ty <= (rect.br().y - 1) / tileSize; ty++) {
+        for (int tx = rect.x / tileSize; tx <= (rect.br().x - 1) / tileSize; tx++) {
+            const Mat &t = tile(level, tx, ty);
+            Rect tile_rect(tx * tileSize, ty * tileSize, t.cols, t.rows);
+            Rect inter = tile_rect & rect;
+            t(inter - tile_rect.tl()).copyTo(dst(inter - rect.tl()));
+        }
+    }
+}
+
+TiledViewer::TiledViewer(const string &window, const TiledViewerOptions &options) : window(window), options(options) {
+    namedWindow(window, WINDOW_AUTOSIZE);
+    cv::setMouseCallback(window, mouseHandler, this);
+}
+
+TiledViewer::~TiledViewer() {
+    // the window may already be closed (destroyAllWindows), then there is nothing left pointing here
+    try {
+        destroyWindow(window);
+    } catch (const cv::Exception &) {
+    }
+}
+
+const string &TiledViewer::windowName() const {
+    return window;
+}
+
+void TiledViewer::show(const Mat &image) {
+    Size previous = pyramid.size();
+    pyramid.build(image, options, window);
+
+    if (pyramid.size() != previous)
+        fitView();
+    clampView();
+    render();
+}
+
+bool TiledViewer::open(const string &path) {
+    if (!pyramid.open(path, options))
+        return false;
+
+    fitView();
+    render();
+    return true;
+}
+
+void TiledViewer::setMouseCallback(MouseCallback callback, void *userdata) {
+    this->callback = callback;
+    this->userdata = userdata;
+}
+
+Point2d TiledViewer::toImage(const Point &window_point) const {
+    return origin + Point2d(window_point) / scale;
+}
+
+double TiledViewer::fitScale() const {
+    Size size = pyramid.size();
+    if (size.area() == 0)
+        return 1;
+    return min(1.0, min((double) options.viewport.width / size.width, (double) options.viewport.height / size.height));
+}
+
+// the window shrinks to the image when all of it is visible
+Size TiledViewer::canvasSize() const {
+    Size size = pyramid.size();
+    return Size(max(1, min(options.viewport.width, (int) ceil(size.width * scale))),
+                max(1, min(options.viewport.height, (int) ceil(size.height * scale))));
+}
+
+void TiledViewer::fitView() {
+    scale = fitScale();
+    origin = Point2d(0, 0);
+}
+
+void TiledViewer::clampView() {
+    Size size = pyramid.size();
+    Size canvas_size = canvasSize();
+    origin.x = max(0.0, min(origin.x, size.width - canvas_size.width / scale));
+    origin.y = max(0.0, min(origin.y, size.height - canvas_size.height / scale));
+}
+
+void TiledViewer::fit() {
+    fitView();
+    render();
+}
+
+void TiledViewer::zoom(double factor, const Point &window_point) {
+    Point2d fixed = toImage(window_point);
+    scale = max(fitScale(), min(32.0, scale * factor));
+    origin = fixed - Point2d(window_point) / scale;
+    clampView();
+    render();
+}
+
+void TiledViewer::pan(double dx, double dy) {
+    origin += Point2d(dx, dy) / scale;
+    clampView();
+    render();
+}
+
+void TiledViewer::render() {
+    if (pyramid.empty())
+        return;
+
+    TRACE_SCOPE("core.tiled_viewer_render");
+
+    // smallest level still having at least one pixel per window pixel
+    int level = 0;
+    while (level + 1 < pyramid.levels() && scale * (1 << (level + 1)) <= 1.0)
+        level++;
+    const double level_factor = 1 << level;
+    const double s = scale * level_factor;
+
+    Size canvas_size = canvasSize();
+    Point2d tl = origin / level_factor;
+    Point2d br = tl + Point2d(canvas_size.width / s, canvas_size.height / s);
+    Point first((int) floor(tl.x), (int) floor(tl.y));
+    Rect visible = Rect(first, Point((int) ceil(br.x), (int) ceil(br.y))) & Rect(Point(0, 0), pyramid.levelSize(level));
+
+    pyramid.read(level, visible, region);
+    if (region.empty()) {
+        canvas = Mat::zeros(canvas_size, region.type());
+        imshow(window, canvas);
+        return;
+    }
+
+    // window pixel u shows the level pixel tl.x + u / s
+    Mat transform = (Mat_<double>(2, 3) << s, 0, -s * (tl.x - visible.x), 0, s, -s * (tl.y - visible.y));
+    warpAffine(region, canvas, transform, canvas_size, s >= 1 ? INTER_NEAREST : INTER_LINEAR, BORDER_CONSTANT);
+
+    imshow(window, canvas);
+}
+
+void TiledViewer::onMouse(int event, int x, int y, int flags) {
+    switch (event) {
+        case EVENT_MOUSEWHEEL:
+            zoom(getMouseWheelDelta(flags) > 0 ? 1.25 : 0.8, Point(x, y));
+            return;
+        case EVENT_RBUTTONDOWN:
+        case EVENT_MBUTTONDOWN:
+            dragging = true;
+            dragStart = Point(x, y);
+            return;
+        case EVENT_RBUTTONUP:
+        case EVENT_MBUTTONUP:
+            dragging = false;
+            return;
+        case EVENT_LBUTTONDBLCLK:
+            fit();
+            return;
+        case EVENT_MOUSEMOVE:
+            if (dragging) {
+                pan(dragStart.x - x, dragStart.y - y);
+                dragStart = Point(x, y);
+                return;
+            }
+            break;
+        default:
+            break;
+    }
+
+    if (!callback)
+        return;
+
+    Point2d p = toImage(Point(x, y));
+    Size size = pyramid.size();
+    if (p.x >= 0 && p.y >= 0 && p.x < size.width && p.y < size.height)
+        callback(event, (int) p.x, (int) p.y, flags, userdata);
+}
+
+void TiledViewer::mouseHandler(int event, int x, int y, int flags, void *viewer) {
+    ((TiledViewer*) viewer)->onMouse(event, x, y, flags);
+}
+
+bool TiledViewer::handleKey(int key) {
+    Size canvas_size = canvasSize();
+    Point center(canvas_size.width / 2, canvas_size.height / 2);
+
+    switch (key) {
+        case '+':
+        case '=':
+            zoom(1.25, center);
+            return true;
+        case '-':
+            zoom(0.8, center);
+            return true;
+        case 'w':
+            pan(0, -canvas_size.height / 4.0);
+            return true;
+        case 's':
+            pan(0, canvas_size.height / 4.0);
+            return true;
+        case 'a':
+            pan(-canvas_size.width / 4.0, 0);
+            return true;
+        case 'd':
+            pan(canvas_size.width / 4.0, 0);
+            return true;
+        case 'f':
+            fit();
+            return true;
+        case '1':
+            zoom(1 / scale, center);
+            return true;
+        default:
+            return false;
+    }
+}
+
+int TiledViewer::waitKey(int delay) {
+    while (true) {
+        int key = cv::waitKey(delay);
+        if (key < 0 || !handleKey(key & 0xFF))
+            return key;
+        if (delay > 0)
+            return -1;
+    }
+}
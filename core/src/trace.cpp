@@ -0,0 +1,220 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "vision_core/trace.h"
+
+using namespace std;
+
+namespace trace {
+
+    // Events kept for the Chrome trace per thread, stage statistics keep counting after the limit
+    const size_t MAX_EVENTS_PER_THREAD = 1 << 20;
+    // Durations kept per stage and thread for the percentiles, a uniform sample of all of them beyond this
+    const size_t MAX_SAMPLES_PER_STAGE = 4096;
+
+    struct Event {
+        const char *name;
+        int64_t start;
+        int64_t end;
+    };
+
+    /**
+     * Statistics of a stage in bounded memory: count, total and max are exact, the percentiles come from
+     * a reservoir sample of the durations.
+     */
+    struct StageStats {
+        int64_t count = 0;
+        int64_t total = 0;
+        int64_t max = 0;
+        vector<int64_t> samples;
+    };
+
+    /**
+     * Per-thread recording buffer. Its mutex is only contended during a flush.
+     */
+    struct ThreadBuffer {
+        int tid;
+        mutex lock;
+        vector<Event> events;
+        map<const char*, StageStats> stages;
+        // state of the generator of the reservoir sampling (xorshift64)
+        uint64_t random = 0x9e3779b97f4a7c15ULL;
+    };
+
+    struct State {
+        atomic<bool> enabled{false};
+        string prefix;
+        int64_t origin = 0;
+
+        mutex lock;
+        vector<shared_ptr<ThreadBuffer>> buffers;
+        map<string, int64_t> counters;
+    };
+
+    static State& state() {
+        static State s;
+        return s;
+    }
+
+    static ThreadBuffer& threadBuffer() {
+        // owned by the state as well, so that events survive the thread
+        thread_local shared_ptr<ThreadBuffer> buffer;
+        if (!buffer) {
+            buffer = make_shared<ThreadBuffer>();
+            State &s = state();
+            lock_guard<mutex> guard(s.lock);
+            buffer->tid = s.buffers.size();
+            s.buffers.push_back(buffer);
+        }
+        return *buffer;
+    }
+
+    static bool initFromEnvironment() {
+        const char *prefix = getenv("CVLAB_TRACE");
+        if (prefix && *prefix)
+            enable(prefix);
+        return true;
+    }
+
+    static bool env_initialized = initFromEnvironment();
+
+    bool enabled() {
+        return state().enabled.load(memory_order_relaxed);
+    }
+
+    void enable(const string &output_prefix) {
+        State &s = state();
+        {
+            lock_guard<mutex> guard(s.lock);
+            s.prefix = output_prefix;
+            s.origin = nowNs();
+        }
+
+        if (!s.enabled.exchange(true))
+            atexit(flush);
+    }
+
+    void record(const char *name, int64_t start_ns, int64_t end_ns) {
+        ThreadBuffer &buffer = threadBuffer();
+        lock_guard<mutex> guard(buffer.lock);
+
+        if (buffer.events.size() < MAX_EVENTS_PER_THREAD)
+            buffer.events.push_back({ name, start_ns, end_ns });
+
+        int64_t duration = end_ns - start_ns;
+        StageStats &stage = buffer.stages[name];
+        stage.count++;
+        stage.total += duration;
+        stage.max = max(stage.max, duration);
+        if (stage.samples.size() < MAX_SAMPLES_PER_STAGE) {
+            stage.samples.push_back(duration);
+        } else {
+            // reservoir sampling: the n-th duration replaces a kept one with probability MAX_SAMPLES_PER_STAGE / n
+            buffer.random ^= buffer.random << 13;
+            buffer.random ^= buffer.random >> 7;
+            buffer.random ^= buffer.random << 17;
+            uint64_t slot = buffer.random % (uint64_t) stage.count;
+            if (slot < MAX_SAMPLES_PER_STAGE)
+                stage.samples[slot] = duration;
+        }
+    }
+
+    void count(const char *name, int64_t value) {
+        State &s = state();
+        lock_guard<mutex> guard(s.lock);
+        s.counters[name] += value;
+    }
+
+    static string escape(const string &str) {
+        string out;
+        for (char c : str) {
+            if (c == '"' || c == '\\')
+                out += '\\';
+            out += c;
+        }
+        return out;
+    }
+
+    /**
+     * Durations sampled by the threads of a stage, each weighted by the durations it stands for
+     * (count / samples of its thread), so that threads recording more weigh more.
+     */
+    struct StageSummary {
+        int64_t count = 0;
+        int64_t total = 0;
+        int64_t max = 0;
+        vector<pair<int64_t, double>> samples;
+    };
+
+    static double percentile(const vector<pair<int64_t, double>> &sorted, double weight, double p) {
+        double target = p * weight, cumulative = 0;
+        for (const auto &s : sorted) {
+            cumulative += s.second;
+            if (cumulative >= target)
+                return s.first / 1e6;
+        }
+        return sorted.back().first / 1e6;
+    }
+
+    void flush() {
+        State &s = state();
+        if (!s.enabled)
+            return;
+
+        lock_guard<mutex> guard(s.lock);
+
+        ofstream json(s.prefix + ".json");
+        json << "{\"traceEvents\":[";
+        bool first = true;
+        int64_t last_ts = s.origin;
+        map<string, StageSummary> stages;
+
+        for (const auto &buffer : s.buffers) {
+            lock_guard<mutex> buffer_guard(buffer->lock);
+
+            for (const auto &e : buffer->events) {
+                json << (first ? "" : ",") << "\n{\"name\":\"" << escape(e.name) << "\",\"ph\":\"X\",\"pid\":1,\"tid\":"
+                     << buffer->tid << ",\"ts\":" << (e.start - s.origin) / 1e3 << ",\"dur\":" << (e.end - e.start) / 1e3 << "}";
+                first = false;
+                last_ts = max(last_ts, e.end);
+            }
+
+            // the same stage name may come from different string literals
+            for (const auto &d : buffer->stages) {
+                StageSummary &summary = stages[d.first];
+                summary.count += d.second.count;
+                summary.total += d.second.total;
+                summary.max = max(summary.max, d.second.max);
+                double weight = (double) d.second.count / d.second.samples.size();
+                for (int64_t v : d.second.samples)
+                    summary.samples.emplace_back(v, weight);
+            }
+        }
+
+        for (const auto &c : s.counters) {
+            json << (first ? "" : ",") << "\n{\"name\":\"" << escape(c.first) << "\",\"ph\":\"C\",\"pid\":1,\"ts\":"
+                 << (last_ts - s.origin) / 1e3 << ",\"args\":{\"value\":" << c.second << "}}";
+            first = false;
+        }
+        json << "\n]}\n";
+
+        ofstream csv(s.prefix + ".csv");
+        csv << "stage,count,total_ms,mean_ms,p50_ms,p95_ms,p99_ms,max_ms\n";
+        for (auto &stage : stages) {
+            StageSummary &d = stage.second;
+            sort(d.samples.begin(), d.samples.end());
+
+            double total = d.total / 1e6;
+            csv << stage.first << "," << d.count << "," << total << "," << total / d.count << ","
+                << percentile(d.samples, d.count, 0.5) << "," << percentile(d.samples, d.count, 0.95) << ","
+                << percentile(d.samples, d.count, 0.99) << "," << d.max / 1e6 << "\n";
+        }
+        for (const auto &c : s.counters)
+            csv << c.first << "," << c.second << ",,,,,,\n";
+    }
+}
@@ -0,0 +1,410 @@
+#include <algorithm>
+#include <iostream>
+#include <opencv2/calib3d.hpp>
+#include <opencv2/imgproc.hpp>
+#include <opencv2/video/tracking.hpp>
+#include "vision_core/async_video_io.h"
+#include "vision_core/features.h"
+#include "vision_core/frame_pyramid_cache.h"
+#include "vision_core/trace.h"
+#include "vision_core/tracking_session.h"
+
+using namespace std;
+using namespace cv;
+
+TrackingSession::TrackingSession(const ObjectModelRegistry &models, TrackingConfig config)
+    : models(models), config(config) {
+    // the registry detector can't be shared between sessions running concurrently
+    detector = createSiftDetector();
+
+    // assign a random color to each object
+    RNG rng;
+    for (int i = 0; i < models.size(); i++) {
+        int r = rng.uniform(0, 256);
+        int g = rng.uniform(0, 256);
+        int b = rng.uniform(0, 256);
+        colors.push_back(Scalar(r,g,b));
+    }
+}
+
+bool TrackingSession::run(const string &video_path, const string &output_path, SessionStats &stats) {
+    stats = SessionStats();
+
+    // Decode and encode run on their own threads, recycling a fixed ring of frame buffers
+    AsyncVideoReader reader(video_path, config.frame_ring_size);
+    if (!reader.isOpened())
+        return false;
+
+    RedetectionWorker redetector(models, config.ransac_reproject_error);
+    FramePyramidCache pyramids(config.lk_win_size, config.lk_max_pyr_lev);
+    AsyncVideoWriter video;
+
+    int frame_index = 0;
+    int last_request_frame = 0;
+    vector<int> last_candidates;
+    int64 start = getTickCount();
+
+    Mat *frame;
+    while ((frame = reader.next()) != nullptr) {
+        TRACE_SCOPE("lab6.frame");
+        Mat &curr_frame = *frame;
+        {
+            TRACE_SCOPE("lab6.build_pyramid");
+            pyramids.push(curr_frame);
+        }
+
+        if (frame_index == 0) {
+            initTracking(curr_frame, pyramids.currentGray());
+            video.open(output_path, VideoWriter::fourcc('M','J','P','G'), config.output_fps, curr_frame.size());
+        } else {
+            updateAllObjects(pyramids.previous(), pyramids.current(), pyramids.currentGray());
+
+            // Merge the objects found by the background re-detection, never waiting for it
+            vector<Redetection> redetections;
+            bool redetector_idle = redetector.collect(redetections);
+            mergeRedetections(redetections, pyramids.currentGray());
+
+            // Schedule a re-detection periodically, or as soon as the set of lost/degrading objects changes
+            vector<int> candidates = redetectionCandidates();
+            bool scheduled = frame_index - last_request_frame >= config.redetect_interval || candidates != last_candidates;
+
+            if (redetector_idle && !candidates.empty() && scheduled) {
+                redetector.request(curr_frame, frame_index, candidates);
+                last_request_frame = frame_index;
+                last_candidates = candidates;
+            }
+        }
+
+        {
+            TRACE_SCOPE("lab6.draw");
+            drawObjects(curr_frame);
+        }
+
+        // the frame goes back to the reader once encoded
+        video.write(frame, [&reader](Mat *f) { reader.recycle(f); });
+        frame_index++;
+    }
+
+    video.release();
+
+    stats.frames = frame_index;
+    stats.seconds = (getTickCount() - start) / getTickFrequency();
+    stats.decode_seconds = reader.decodeSeconds();
+    stats.encode_seconds = video.encodeSeconds();
+    stats.wait_seconds = reader.waitSeconds();
+    for (bool failed : tracking_failed)
+        stats.lost_objects += failed;
+
+    return true;
+}
+
+/**
+ * Detects the objects on the starting frame, initializing keypoints and outline of each object.
+ */
+void TrackingSession::initTracking(const Mat &frame, const Mat &gray) {
+    vector<KeyPoint> video_keypoints;
+    Mat video_descriptor;
+    vector<vector<DMatch>> matches;
+
+    {
+        TRACE_SCOPE("lab6.sift_detect_compute");
+        detector->detectAndCompute(frame, noArray(), video_keypoints, video_descriptor);
+    }
+    models.matchAll(video_descriptor, matches);
+
+    outline_points_obj.clear();
+    pts_to_track_obj.clear();
+    initial_points.clear();
+
+    for (int i = 0; i < models.size(); i++) {
+        vector<Point2f> outline_points;
+        vector<Point2f> features;
+
+        // Object not found, leave it without keypoints so that it is marked as failed
+        if (!models.locate(i, video_keypoints, matches[i], config.ransac_reproject_error, outline_points, features)) {
+            if (config.verbose)
+                cout << "Object not found: " << models[i].name << endl;
+            outline_points = vector<Point2f>(4);
+        } else {
+            reseed(features, outline_points, gray);
+            applyBudget(features, outline_points);
+        }
+
+        pts_to_track_obj.push_back(features);
+        outline_points_obj.push_back(outline_points);
+        initial_points.push_back(features.size());
+    }
+
+    tracking_failed = vector<bool>(pts_to_track_obj.size(), false);
+}
+
+/**
+ * @param prev_pyr pyramid of the previous frame, built with buildOpticalFlowPyramid
+ * @param curr_pyr pyramid of the current frame, built with buildOpticalFlowPyramid
+ * @param discarded will hold the number of keypoints discarded as outliers
+ * @return false if tracking failed, true otherwise
+ */
+bool TrackingSession::updateKeypointsAndOutline(const vector<Mat> &prev_pyr, const vector<Mat> &curr_pyr, const Mat &curr_gray,
+                                                vector<Point2f> &pts_to_track, vector<Point2f> &outline_pts, int &discarded) const {
+    discarded = 0;
+    if (pts_to_track.empty()) {
+        return false;
+    }
+
+    vector<uchar> status, back_status;
+    vector<float> err;
+    vector<Point2f> keypoints_destination;
+    vector<Point2f> keypoints_back;
+
+    {
+        TRACE_SCOPE("lab6.lk_forward");
+        calcOpticalFlowPyrLK(prev_pyr, curr_pyr, pts_to_track, keypoints_destination, status, err, config.lk_win_size, config.lk_max_pyr_lev);
+    }
+
+    // Track back to the previous frame, starting from the original positions so that it converges quickly
+    keypoints_back = pts_to_track;
+    {
+        TRACE_SCOPE("lab6.lk_backward");
+        calcOpticalFlowPyrLK(curr_pyr, prev_pyr, keypoints_destination, keypoints_back, back_status, err, config.lk_win_size,
+                             config.lk_max_pyr_lev, TermCriteria(TermCriteria::COUNT + TermCriteria::EPS, 30, 0.01), OPTFLOW_USE_INITIAL_FLOW);
+    }
+
+    // Keep only the keypoints tracked in both directions and coming back where they started,
+    // sorted by forward-backward error: the best ones come first, as expected by PROSAC
+    vector<pair<float, int>> consistent;
+    for (int j = 0; j < pts_to_track.size(); j++) {
+        if (!status[j] || !back_status[j])
+            continue;
+        float fb_error = (float) norm(keypoints_back[j] - pts_to_track[j]);
+        if (fb_error <= config.max_fb_error)
+            consistent.push_back(make_pair(fb_error, j));
+    }
+    sort(consistent.begin(), consistent.end());
+
+    discarded = pts_to_track.size() - consistent.size();
+    TRACE_COUNT("lab6.fb_rejected_points", discarded);
+    if (consistent.size() < 4)
+        return false;
+
+    vector<Point2f> src, dst;
+    for (const auto &c : consistent) {
+        src.push_back(pts_to_track[c.second]);
+        dst.push_back(keypoints_destination[c.second]);
+    }
+
+    // RHO is a PROSAC-based estimator with adaptive number of iterations, it stops early on good data
+    vector<uint8_t> mask;
+    Mat H;
+    {
+        TRACE_SCOPE("lab6.track_homography");
+        H = findHomography(src, dst, RHO, config.ransac_reproject_error, mask, config.ransac_max_iters, config.ransac_confidence);
+    }
+
+    // Case homography not found
+    if (H.empty())
+        return false;
+
+    // Move rectangle according with the homography
+    perspectiveTransform(outline_pts, outline_pts, H);
+
+    // Filter outliers and update keypoints to track
+    pts_to_track.clear();
+    for (int j = 0; j < dst.size(); j++) {
+        if (mask[j])
+            pts_to_track.push_back(dst[j]);
+        else
+            discarded++;
+    }
+
+    // Keep the LK cost of the object bounded and its keypoints spread over the object
+    reseed(pts_to_track, outline_pts, curr_gray);
+    applyBudget(pts_to_track, outline_pts);
+    return true;
+}
+
+/**
+ * Updates every object still tracked, running the per-object updates concurrently on the OpenCV thread pool.
+ * The frame pyramids (with derivatives) are shared by all the objects,
+ * instead of being rebuilt by each calcOpticalFlowPyrLK call.
+ */
+void TrackingSession::updateAllObjects(const vector<Mat> &prev_pyr, const vector<Mat> &curr_pyr, const Mat &curr_gray) {
+    // vector<bool> is packed and can't be written concurrently
+    vector<uchar> success(pts_to_track_obj.size(), 0);
+    vector<int> discarded(pts_to_track_obj.size(), 0);
+
+    parallel_for_(Range(0, (int) pts_to_track_obj.size()), [&](const Range &range) {
+        for (int i = range.start; i < range.end; i++) {
+            if (tracking_failed[i])
+                continue;
+            success[i] = updateKeypointsAndOutline(prev_pyr, curr_pyr, curr_gray, pts_to_track_obj[i], outline_points_obj[i], discarded[i]);
+        }
+    });
+
+    for (int i = 0; i < pts_to_track_obj.size(); i++) {
+        if (tracking_failed[i])
+            continue;
+
+        if (discarded[i] && config.verbose)
+            cout << discarded[i] << " keypoints discarded for obj: " << i << endl;
+
+        if (!success[i]) {
+            tracking_failed[i] = true;
+            if (config.verbose)
+                cout << "Tracking failed for obj: " << i << endl;
+        }
+    }
+}
+
+/**
+ * Moves the outline and keypoints of a re-detection from the (older) frame it has been computed on to the current frame.
+ * @return false if the re-detection can't be tracked up to the current frame
+ */
+bool TrackingSession::catchUpRedetection(Redetection &detection, const Mat &curr_gray) const {
+    vector<uchar> status;
+    vector<float> err;
+    vector<Point2f> moved;
+    TRACE_SCOPE("lab6.catch_up_redetection");
+    calcOpticalFlowPyrLK(detection.gray, curr_gray, detection.points, moved, status, err, config.lk_win_size, config.catch_up_pyr_lev);
+
+    vector<Point2f> src, dst;
+    for (int j = 0; j < moved.size(); j++) {
+        if (!status[j]) continue;
+        src.push_back(detection.points[j]);
+        dst.push_back(moved[j]);
+    }
+    if (src.size() < 4)
+        return false;
+
+    vector<uint8_t> mask;
+    Mat H = findHomography(src, dst, RANSAC, config.ransac_reproject_error, mask);
+    if (H.empty())
+        return false;
+
+    perspectiveTransform(detection.outline, detection.outline, H);
+    detection.points.clear();
+    for (int j = 0; j < dst.size(); j++) {
+        if (mask[j])
+            detection.points.push_back(dst[j]);
+    }
+
+    reseed(detection.points, detection.outline, curr_gray);
+    applyBudget(detection.points, detection.outline);
+    return true;
+}
+
+/**
+ * Adds to pts the strongest corners (goodFeaturesToTrack) inside the outline, if pts has less than
+ * min_points_per_object keypoints. Corners close to the keypoints already tracked are skipped.
+ */
+void TrackingSession::reseed(vector<Point2f> &pts, const vector<Point2f> &outline, const Mat &gray) const {
+    if (pts.size() >= config.min_points_per_object)
+        return;
+
+    // work on the bounding box of the outline only
+    Rect roi = boundingRect(outline) & Rect(0, 0, gray.cols, gray.rows);
+    if (roi.area() == 0)
+        return;
+
+    Mat mask = Mat::zeros(roi.size(), CV_8U);
+    vector<Point> quad;
+    for (int k : { 0, 1, 3, 2 })
+        quad.push_back(Point(cvRound(outline[k].x) - roi.x, cvRound(outline[k].y) - roi.y));
+    fillConvexPoly(mask, quad, Scalar(255));
+
+    for (const auto &p : pts)
+        circle(mask, Point(cvRound(p.x) - roi.x, cvRound(p.y) - roi.y), config.reseed_min_distance, Scalar(0), -1);
+
+    TRACE_SCOPE("lab6.reseed");
+    vector<Point2f> corners;
+    int wanted = max(config.max_points_per_object - (int) pts.size(), 1);
+    goodFeaturesToTrack(gray(roi), corners, wanted, 0.01, config.reseed_min_distance, mask);
+
+    for (const auto &c : corners)
+        pts.push_back(c + Point2f(roi.x, roi.y));
+}
+
+/**
+ * Keeps at most max_points_per_object keypoints, spatially uniform: keypoints are bucketed in a
+ * budget_grid x budget_grid grid over the bounding box of the outline, then picked one per cell in turn.
+ */
+void TrackingSession::applyBudget(vector<Point2f> &pts, const vector<Point2f> &outline) const {
+    if (pts.size() <= config.max_points_per_object)
+        return;
+
+    int grid = config.budget_grid;
+    Rect box = boundingRect(outline);
+    float cell_w = max(box.width, 1) / (float) grid;
+    float cell_h = max(box.height, 1) / (float) grid;
+
+    vector<vector<int>> cells(grid * grid);
+    for (int j = 0; j < pts.size(); j++) {
+        int cx = min(max((int) ((pts[j].x - box.x) / cell_w), 0), grid - 1);
+        int cy = min(max((int) ((pts[j].y - box.y) / cell_h), 0), grid - 1);
+        cells[cy * grid + cx].push_back(j);
+    }
+
+    vector<Point2f> kept;
+    for (int round = 0; kept.size() < config.max_points_per_object; round++) {
+        bool picked = false;
+        for (const auto &cell : cells) {
+            if (round >= cell.size() || kept.size() == config.max_points_per_object)
+                continue;
+            kept.push_back(pts[cell[round]]);
+            picked = true;
+        }
+        if (!picked)
+            break;
+    }
+    pts = kept;
+}
+
+void TrackingSession::mergeRedetections(vector<Redetection> &redetections, const Mat &curr_gray) {
+    for (auto &detection : redetections) {
+        int i = detection.object;
+        if (!catchUpRedetection(detection, curr_gray))
+            continue;
+
+        // the track may have improved meanwhile
+        if (!tracking_failed[i] && detection.points.size() <= pts_to_track_obj[i].size())
+            continue;
+
+        if (tracking_failed[i] && config.verbose)
+            cout << "Tracking recovered for obj: " << i << endl;
+
+        pts_to_track_obj[i] = detection.points;
+        outline_points_obj[i] = detection.outline;
+        initial_points[i] = detection.points.size();
+        tracking_failed[i] = false;
+    }
+}
+
+/**
+ * @return ids of the objects lost or whose number of keypoints dropped below redetect_min_points_ratio
+ */
+vector<int> TrackingSession::redetectionCandidates() const {
+    vector<int> candidates;
+    for (int i = 0; i < pts_to_track_obj.size(); i++) {
+        if (tracking_failed[i] || pts_to_track_obj[i].size() < config.redetect_min_points_ratio * initial_points[i])
+            candidates.push_back(i);
+    }
+    return candidates;
+}
+
+/**
+ * Prints rectangles and keypoints of the objects tracked.
+ */
+void TrackingSession::drawObjects(Mat &frame) const {
+    for (int j = 0; j < outline_points_obj.size(); j++) {
+        if (tracking_failed[j])
+            continue;
+
+        const vector<Point2f> &outline_points = outline_points_obj[j];
+        line(frame, outline_points[0], outline_points[1], colors[j], 2);
+        line(frame, outline_points[1], outline_points[3], colors[j], 2);
+        line(frame, outline_points[3], outline_points[2], colors[j], 2);
+        line(frame, outline_points[2], outline_points[0], colors[j], 2);
+
+        for (const auto &keypoint : pts_to_track_obj[j])
+            circle(frame, keypoint, 3, colors[j]);
+    }
+}
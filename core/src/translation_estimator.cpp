@@ -0,0 +1,118 @@
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+#include "vision_core/trace.h"
+#include "vision_core/translation_estimator.h"
+
+using namespace cv;
+using namespace std;
+
+// histogram peaks tried by VOTE, more than one to measure how much the best stands out
+static const int VOTE_CANDIDATES = 8;
+
+TranslationEstimator::TranslationEstimator(const Params &params) : params(params) {}
+
+void TranslationEstimator::candidates(const Mat &displacements, vector<Point2f> &result) const {
+    const Point2f *d = displacements.ptr<Point2f>();
+    const int n = (int) displacements.total();
+    result.clear();
+
+    if (params.method == RANSAC_1PT) {
+        if (n <= params.iterations) {
+            result.assign(d, d + n);
+        } else {
+            // fixed seed: the same matches always give the same estimate
+            RNG rng(0x5eed);
+            for (int i = 0; i < params.iterations; i++)
+                result.push_back(d[rng.uniform(0, n)]);
+        }
+        return;
+    }
+
+    unordered_map<uint64_t, int> bins;
+    for (int i = 0; i < n; i++) {
+        int64_t bx = (int64_t) floor(d[i].x / params.binSize);
+        int64_t by = (int64_t) floor(d[i].y / params.binSize);
+        // unsigned: shifting a negative bin (the usual case of panorama offsets) left is undefined
+        bins[((uint64_t) bx << 32) ^ (uint32_t) by]++;
+    }
+
+    vector<pair<int, uint64_t>> peaks;
+    peaks.reserve(bins.size());
+    for (const auto &bin : bins)
+        peaks.emplace_back(bin.second, bin.first);
+    int k = min((int) peaks.size(), VOTE_CANDIDATES);
+    partial_sort(peaks.begin(), peaks.begin() + k, peaks.end(), greater<pair<int, uint64_t>>());
+
+    // bin centers, the refinement on the inliers moves them to the actual translation
+    for (int i = 0; i < k; i++) {
+        int32_t bx = (int32_t) (uint32_t) (peaks[i].second >> 32);
+        int32_t by = (int32_t) (uint32_t) peaks[i].second;
+        result.emplace_back((bx + 0.5f) * params.binSize, (by + 0.5f) * params.binSize);
+    }
+}
+
+TranslationEstimate TranslationEstimator::estimate(const vector<Point2f> &src, const vector<Point2f> &dst) const {
+    TRACE_SCOPE("core.translation_estimate");
+    CV_Assert(src.size() == dst.size());
+
+    TranslationEstimate result;
+    result.inliers.assign(src.size(), 0);
+    if (src.empty())
+        return result;
+
+    // N x 1 CV_32FC2 displacements, every candidate is scored on all of them with a few vectorized passes
+    Mat displacements;
+    subtract(Mat(dst), Mat(src), displacements);
+
+    Mat diff;
+    const Scalar tolerance(params.threshold, params.threshold);
+    auto score = [&](const Point2f &t, Mat &mask) {
+        absdiff(displacements, Scalar(t.x, t.y), diff);
+        inRange(diff, Scalar(0, 0), tolerance, mask);
+        return countNonZero(mask);
+    };
+
+    vector<Point2f> tried;
+    candidates(displacements, tried);
+
+    vector<int> support(tried.size());
+    Mat mask, best_mask;
+    int best = -1;
+    for (int i = 0; i < (int) tried.size(); i++) {
+        support[i] = score(tried[i], mask);
+        if (best < 0 || support[i] > support[best]) {
+            best = i;
+            mask.copyTo(best_mask);
+        }
+    }
+
+    // mean displacement of the inliers, kept if it doesn't lose support
+    Point2f translation = tried[best];
+    int inliers = support[best];
+    Scalar mean_inliers = mean(displacements, best_mask);
+    Point2f refined((float) mean_inliers[0], (float) mean_inliers[1]);
+    int refined_inliers = score(refined, mask);
+    if (refined_inliers >= inliers) {
+        translation = refined;
+        inliers = refined_inliers;
+        mask.copyTo(best_mask);
+    }
+
+    // best support of a clearly different translation
+    int second = 0;
+    for (int i = 0; i < (int) tried.size(); i++) {
+        Point2f d = tried[i] - translation;
+        if (max(fabs(d.x), fabs(d.y)) > 2 * params.threshold)
+            second = max(second, support[i]);
+    }
+
+    result.translation = translation;
+    result.inlierCount = inliers;
+    const uchar *m = best_mask.ptr<uchar>();
+    for (size_t i = 0; i < result.inliers.size(); i++)
+        result.inliers[i] = m[i] ? 1 : 0;
+    result.confidence = inliers > 0 ? max(0.0, 1.0 - (double) second / inliers) : 0;
+    result.valid = inliers >= params.minInliers && result.confidence >= params.minConfidence;
+    return result;
+}